@@ -2,102 +2,2672 @@
 
 #include <vector>
 #include <mutex>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <future>
+#include <coroutine>
+#include <atomic>
 #include <memory>
+#include <memory_resource>
 #include <functional>
+#include <new>
+#include <optional>
+#include <span>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <tuple>
+#include <cstddef>
+#include <concepts>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
-template <typename FunctionType>
+template <typename FunctionType, std::size_t BufferSize = 32, bool Copyable = true>
 class FunctionWrapper;
 
-template <typename ReturnType, typename... Args>
-class FunctionWrapper<ReturnType(Args...)>
+template <typename FunctionType, std::size_t BufferSize = 32>
+using MoveOnlyFunctionWrapper = FunctionWrapper<FunctionType, BufferSize, false>;
+
+// Type-erased callable with an in-place buffer. Callables that fit into BufferSize (and are nothrow movable)
+// are stored inline, larger ones fall back to a memory resource (the default one unless given). This move-only
+// wrapper takes any callable, the copyable one below only copyable callables, so that copying one always works.
+template <std::size_t BufferSize, typename ReturnType, typename... Args>
+class FunctionWrapper<ReturnType(Args...), BufferSize, false>
 {
-    using std::function<ReturnType(Args...)>::function;
+    static_assert(BufferSize >= sizeof(void*), "FunctionWrapper buffer must be able to hold a pointer");
+
+public:
+    // How InvokeShared receives an argument: by-value and rvalue reference parameters are only lent out as const
+    // references, lvalue references are passed on as they are.
+    template <typename T>
+    using SharedArgument = std::conditional_t<std::is_lvalue_reference_v<T>, T, const std::remove_reference_t<T>&>;
+
+    // A target that cannot borrow a lent argument gets its own copy, which needs a copyable argument type.
+    template <typename T>
+    static constexpr bool copyable_argument = std::is_lvalue_reference_v<T> || std::is_copy_constructible_v<std::remove_cvref_t<T>>;
+
+    // Whether InvokeShared works for a Callable target: it either borrows the arguments or they can be copied for it.
+    template <typename Callable>
+    static constexpr bool shareable = std::is_invocable_r_v<ReturnType, Callable&, SharedArgument<Args>...> ||
+                                      (copyable_argument<Args> && ...);
+
+    template <typename T>
+    static decltype(auto) CopyArgument(SharedArgument<T> argument)
+    {
+        if constexpr (std::is_lvalue_reference_v<T>)
+            return argument;
+        else
+            return std::remove_cvref_t<T>(argument);
+    }
+
+private:
+    friend class FunctionWrapper<ReturnType(Args...), BufferSize, true>;
+
+    struct Operations
+    {
+        ReturnType (*invoke)(void* storage, Args&&... args);
+        ReturnType (*invoke_shared)(void* storage, SharedArgument<Args>... args);
+        void (*copy)(void* destination, const void* source);
+        void (*move)(void* destination, void* source) noexcept;
+        void (*destroy)(void* storage) noexcept;
+        bool (*equals)(const void* storage, const void* other) noexcept;
+    };
+
+    // Targets created by Bind: just an object pointer, the member function is part of the type and thereby of the
+    // operations table, so invoking one is a single indirect call and two bindings can be compared for identity.
+    template <auto Method, typename T>
+    struct BoundMethod
+    {
+        T* object;
+
+        template <typename... Params>
+        ReturnType operator()(Params&&... params) const
+        {
+            return static_cast<ReturnType>(std::invoke(Method, object, std::forward<Params>(params)...));
+        }
+
+        bool operator==(const BoundMethod&) const = default;
+    };
+
+    template <auto Function>
+    struct BoundFunction
+    {
+        template <typename... Params>
+        ReturnType operator()(Params&&... params) const
+        {
+            return static_cast<ReturnType>(std::invoke(Function, std::forward<Params>(params)...));
+        }
+
+        bool operator==(const BoundFunction&) const = default;
+    };
+
+    template <typename Callable>
+    static constexpr bool stored_inline = sizeof(Callable) <= BufferSize &&
+                                          alignof(Callable) <= alignof(std::max_align_t) &&
+                                          std::is_nothrow_move_constructible_v<Callable>;
+
+    // Out-of-line targets remember where they were allocated from.
+    template <typename Callable>
+    struct HeapTarget
+    {
+        std::pmr::memory_resource* resource;
+        Callable callable;
+    };
+
+    template <typename Callable>
+    struct Manager
+    {
+        static Callable& Target(void* storage) noexcept
+        {
+            if constexpr (stored_inline<Callable>)
+                return *std::launder(static_cast<Callable*>(storage));
+            else
+                return (*static_cast<HeapTarget<Callable>**>(storage))->callable;
+        }
+
+        template <typename... Params>
+        static void Create(void* storage, std::pmr::memory_resource* resource, Params&&... params)
+        {
+            if constexpr (stored_inline<Callable>)
+                ::new (storage) Callable(std::forward<Params>(params)...);
+            else
+            {
+                void* memory = resource->allocate(sizeof(HeapTarget<Callable>), alignof(HeapTarget<Callable>));
+                try
+                {
+                    *static_cast<HeapTarget<Callable>**>(storage) =
+                        ::new (memory) HeapTarget<Callable>{resource, Callable(std::forward<Params>(params)...)};
+                }
+                catch (...)
+                {
+                    resource->deallocate(memory, sizeof(HeapTarget<Callable>), alignof(HeapTarget<Callable>));
+                    throw;
+                }
+            }
+        }
+
+        static ReturnType Invoke(void* storage, Args&&... args)
+        {
+            if constexpr (std::is_void_v<ReturnType>)
+                std::invoke(Target(storage), std::forward<Args>(args)...);
+            else
+                return std::invoke(Target(storage), std::forward<Args>(args)...);
+        }
+
+        // Targets that cannot take a const reference (e.g. they declare an rvalue parameter) get a copy. Only
+        // shareable targets have one, for the others the operations table holds no InvokeShared.
+        static ReturnType InvokeShared(void* storage, SharedArgument<Args>... args)
+        {
+            if constexpr (!std::is_invocable_r_v<ReturnType, Callable&, SharedArgument<Args>...>)
+                return Invoke(storage, CopyArgument<Args>(args)...);
+            else if constexpr (std::is_void_v<ReturnType>)
+                std::invoke(Target(storage), std::forward<SharedArgument<Args>>(args)...);
+            else
+                return std::invoke(Target(storage), std::forward<SharedArgument<Args>>(args)...);
+        }
+
+        static void Copy(void* destination, const void* source)
+        {
+            if constexpr (std::is_copy_constructible_v<Callable>)
+            {
+                if constexpr (stored_inline<Callable>)
+                    Create(destination, nullptr, Target(const_cast<void*>(source)));
+                else
+                {
+                    const HeapTarget<Callable>* target = *static_cast<HeapTarget<Callable>* const*>(source);
+                    Create(destination, target->resource, target->callable);
+                }
+            }
+        }
+
+        static void Move(void* destination, void* source) noexcept
+        {
+            if constexpr (stored_inline<Callable>)
+            {
+                Callable& target = Target(source);
+                ::new (destination) Callable(std::move(target));
+                target.~Callable();
+            }
+            else
+                *static_cast<HeapTarget<Callable>**>(destination) = *static_cast<HeapTarget<Callable>**>(source);
+        }
+
+        static void Destroy(void* storage) noexcept
+        {
+            if constexpr (stored_inline<Callable>)
+                Target(storage).~Callable();
+            else
+            {
+                HeapTarget<Callable>* target = *static_cast<HeapTarget<Callable>**>(storage);
+                std::pmr::memory_resource* resource = target->resource;
+                target->~HeapTarget<Callable>();
+                resource->deallocate(target, sizeof(HeapTarget<Callable>), alignof(HeapTarget<Callable>));
+            }
+        }
+
+        static bool Equals(const void* storage, const void* other) noexcept
+        {
+            if constexpr (std::equality_comparable<Callable>)
+                return Target(const_cast<void*>(storage)) == Target(const_cast<void*>(other));
+            else
+                return false;
+        }
+
+        static constexpr auto SharedInvoker() noexcept -> decltype(Operations::invoke_shared)
+        {
+            if constexpr (shareable<Callable>)
+                return &InvokeShared;
+            else
+                return nullptr;
+        }
+
+        static constexpr Operations operations = {
+            &Invoke,
+            SharedInvoker(),
+            std::is_copy_constructible_v<Callable> ? &Copy : nullptr,
+            &Move,
+            &Destroy,
+            std::equality_comparable<Callable> ? &Equals : nullptr};
+    };
+
+    struct EmptyManager
+    {
+        static ReturnType Invoke(void*, Args&&...) { throw std::bad_function_call(); }
+        static ReturnType InvokeShared(void*, SharedArgument<Args>...) { throw std::bad_function_call(); }
+        static void Copy(void*, const void*) {}
+        static void Move(void*, void*) noexcept {}
+        static void Destroy(void*) noexcept {}
+        static bool Equals(const void*, const void*) noexcept { return true; }
+
+        static constexpr Operations operations = {&Invoke, &InvokeShared, &Copy, &Move, &Destroy, &Equals};
+    };
+
 private:
-    std::function<ReturnType(Args...)> func;
+    alignas(std::max_align_t) mutable unsigned char storage[BufferSize];
+    const Operations* operations = &EmptyManager::operations;
+
 public:
-    FunctionWrapper(const std::function<ReturnType(Args...)>& f) : func(f) {}
-    FunctionWrapper(const FunctionWrapper<ReturnType(Args...)>& f) : func(f.func) {}
-    FunctionWrapper(const FunctionWrapper<ReturnType(Args...)>&& f) : func(std::move(f.func)) {}
+    FunctionWrapper() noexcept {}
+
+    template <typename FunctionType,
+              typename Callable = std::decay_t<FunctionType>,
+              typename = std::enable_if_t<!std::is_base_of_v<FunctionWrapper, Callable> &&
+                                          !std::is_same_v<Callable, FunctionWrapper<ReturnType(Args...), BufferSize, true>> &&
+                                          std::is_invocable_r_v<ReturnType, Callable&, Args...>>>
+    FunctionWrapper(FunctionType&& f) : FunctionWrapper(std::allocator_arg, std::pmr::get_default_resource(), std::forward<FunctionType>(f)) {}
+
+    // Allocates a callable that does not fit inline from resource, which must outlive the wrapper and its copies.
+    template <typename FunctionType,
+              typename Callable = std::decay_t<FunctionType>,
+              typename = std::enable_if_t<!std::is_base_of_v<FunctionWrapper, Callable> &&
+                                          std::is_invocable_r_v<ReturnType, Callable&, Args...>>>
+    FunctionWrapper(std::allocator_arg_t, std::pmr::memory_resource* resource, FunctionType&& f)
+    {
+        if constexpr (std::is_pointer_v<Callable> || std::is_member_pointer_v<Callable>)
+        {
+            if (f == nullptr)
+                return;
+        }
+
+        Manager<Callable>::Create(storage, resource, std::forward<FunctionType>(f));
+        operations = &Manager<Callable>::operations;
+    }
+
+    // Constructs the callable right in its final place from params, it is never copied nor moved on the way.
+    template <typename Callable, typename... Params,
+              typename = std::enable_if_t<std::is_constructible_v<Callable, Params...> &&
+                                          std::is_invocable_r_v<ReturnType, Callable&, Args...>>>
+    explicit FunctionWrapper(std::in_place_type_t<Callable>, Params&&... params)
+        : FunctionWrapper(std::allocator_arg, std::pmr::get_default_resource(), std::in_place_type<Callable>, std::forward<Params>(params)...)
+    {
+    }
+
+    template <typename Callable, typename... Params,
+              typename = std::enable_if_t<std::is_constructible_v<Callable, Params...> &&
+                                          std::is_invocable_r_v<ReturnType, Callable&, Args...>>>
+    FunctionWrapper(std::allocator_arg_t, std::pmr::memory_resource* resource, std::in_place_type_t<Callable>, Params&&... params)
+    {
+        static_assert(std::is_same_v<Callable, std::decay_t<Callable>>, "in-place callables must be object types");
+
+        Manager<Callable>::Create(storage, resource, std::forward<Params>(params)...);
+        operations = &Manager<Callable>::operations;
+    }
+
+    FunctionWrapper(const FunctionWrapper&) = delete;
+
+    // Takes a copy of a copyable wrapper's target, which is always possible.
+    FunctionWrapper(const FunctionWrapper<ReturnType(Args...), BufferSize, true>& copyable)
+    {
+        const FunctionWrapper& f = copyable.wrapped;
+        f.operations->copy(storage, f.storage);
+        operations = f.operations;
+    }
+
+    FunctionWrapper(FunctionWrapper<ReturnType(Args...), BufferSize, true>&& copyable) noexcept
+        : FunctionWrapper(std::move(copyable.wrapped))
+    {
+    }
+
+    FunctionWrapper(FunctionWrapper&& f) noexcept : operations(f.operations)
+    {
+        operations->move(storage, f.storage);
+        f.operations = &EmptyManager::operations;
+    }
+
+    ~FunctionWrapper()
+    {
+        operations->destroy(storage);
+    }
+
+    FunctionWrapper& operator=(FunctionWrapper f) noexcept
+    {
+        operations->destroy(storage);
+        operations = f.operations;
+        operations->move(storage, f.storage);
+        f.operations = &EmptyManager::operations;
+        return *this;
+    }
+
+    // Binds a member function to an object without allocating, e.g. FunctionWrapper<void(int)>::Bind<&Foo::OnEvent>(foo).
+    template <auto Method, typename T>
+    static FunctionWrapper Bind(T& object) noexcept
+    {
+        static_assert(std::is_invocable_r_v<ReturnType, decltype(Method), T*, Args...>, "Method cannot be called with these arguments");
+        return BoundMethod<Method, T>{std::addressof(object)};
+    }
+
+    template <auto Function>
+    static FunctionWrapper Bind() noexcept
+    {
+        static_assert(std::is_invocable_r_v<ReturnType, decltype(Function), Args...>, "Function cannot be called with these arguments");
+        return BoundFunction<Function>{};
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return operations != &EmptyManager::operations;
+    }
+
+    // Wrappers are equal when they hold targets of the same type that compare equal, such as the same Bind or the
+    // same function pointer. Targets without operator== (lambdas) only ever equal themselves by address.
+    bool operator==(const FunctionWrapper& f) const noexcept
+    {
+        if (this == &f)
+            return true;
+        return operations == f.operations && operations->equals && operations->equals(storage, f.storage);
+    }
 
     ReturnType operator()(Args... args) const noexcept
     {
-        return func(args...);
+        return operations->invoke(storage, std::forward<Args>(args)...);
     }
-};
 
-template <typename ReturnType, typename... Args>
-class Delegate;
+    // Hands the arguments over to the target, by-value parameters are moved into it.
+    ReturnType Invoke(Args&&... args) const noexcept
+    {
+        return operations->invoke(storage, std::forward<Args>(args)...);
+    }
 
-template <typename ReturnType, typename... Args>
-class Delegate<ReturnType(Args...)>
+    // Lends the arguments to the target without giving them up, so the same arguments can be passed on to
+    // further targets. Only targets taking a parameter by value copy it, a target that takes a move-only argument
+    // by value cannot be lent to at all and throws std::logic_error (see CanShare).
+    ReturnType InvokeShared(SharedArgument<Args>... args) const
+    {
+        if (!operations->invoke_shared)
+            throw std::logic_error("FunctionWrapper: cannot lend move-only arguments to a target taking them by value");
+        return operations->invoke_shared(storage, std::forward<SharedArgument<Args>>(args)...);
+    }
+
+    bool CanShare() const noexcept
+    {
+        return operations->invoke_shared != nullptr;
+    }
+};
+
+// Copyable wrapper: only takes copyable callables, so copying a move-only one fails to compile rather than at
+// run time. It holds a move-only wrapper instead of deriving from one, so that no move-only wrapper reference can
+// refer to it (and have a move-only target assigned). It converts to the move-only wrapper, which adopts its target.
+template <std::size_t BufferSize, typename ReturnType, typename... Args>
+class FunctionWrapper<ReturnType(Args...), BufferSize, true>
 {
-    using function_ptr = std::shared_ptr<FunctionWrapper<ReturnType(Args...)>>;
+    using MoveOnly = FunctionWrapper<ReturnType(Args...), BufferSize, false>;
+
+    friend MoveOnly;
 
+    // A conjunction, so that the move-only wrapper is turned away before asking whether it is copyable, which would
+    // in turn ask whether it converts to this one.
+    template <typename Callable>
+    static constexpr bool accepted = std::conjunction_v<std::negation<std::is_same<Callable, FunctionWrapper>>,
+                                                        std::negation<std::is_same<Callable, MoveOnly>>,
+                                                        std::is_copy_constructible<Callable>,
+                                                        std::is_invocable_r<ReturnType, Callable&, Args...>>;
+
+    MoveOnly wrapped;
+
+public:
+    template <typename T>
+    using SharedArgument = typename MoveOnly::template SharedArgument<T>;
+
+    FunctionWrapper() noexcept {}
+
+    template <typename FunctionType, typename = std::enable_if_t<accepted<std::decay_t<FunctionType>>>>
+    FunctionWrapper(FunctionType&& f) : wrapped(std::forward<FunctionType>(f)) {}
+
+    template <typename FunctionType, typename = std::enable_if_t<accepted<std::decay_t<FunctionType>>>>
+    FunctionWrapper(std::allocator_arg_t, std::pmr::memory_resource* resource, FunctionType&& f)
+        : wrapped(std::allocator_arg, resource, std::forward<FunctionType>(f))
+    {
+    }
+
+    template <typename Callable, typename... Params,
+              typename = std::enable_if_t<accepted<Callable> && std::is_constructible_v<Callable, Params...>>>
+    explicit FunctionWrapper(std::in_place_type_t<Callable> in_place, Params&&... params)
+        : wrapped(in_place, std::forward<Params>(params)...)
+    {
+    }
+
+    template <typename Callable, typename... Params,
+              typename = std::enable_if_t<accepted<Callable> && std::is_constructible_v<Callable, Params...>>>
+    FunctionWrapper(std::allocator_arg_t, std::pmr::memory_resource* resource, std::in_place_type_t<Callable> in_place, Params&&... params)
+        : wrapped(std::allocator_arg, resource, in_place, std::forward<Params>(params)...)
+    {
+    }
+
+    FunctionWrapper(const FunctionWrapper& f) : wrapped(f) {}
+    FunctionWrapper(FunctionWrapper&& f) noexcept : wrapped(std::move(f.wrapped)) {}
+
+    FunctionWrapper& operator=(FunctionWrapper f) noexcept
+    {
+        wrapped = std::move(f.wrapped);
+        return *this;
+    }
+
+    template <auto Method, typename T>
+    static FunctionWrapper Bind(T& object) noexcept
+    {
+        static_assert(std::is_invocable_r_v<ReturnType, decltype(Method), T*, Args...>, "Method cannot be called with these arguments");
+        return typename MoveOnly::template BoundMethod<Method, T>{std::addressof(object)};
+    }
+
+    template <auto Function>
+    static FunctionWrapper Bind() noexcept
+    {
+        static_assert(std::is_invocable_r_v<ReturnType, decltype(Function), Args...>, "Function cannot be called with these arguments");
+        return typename MoveOnly::template BoundFunction<Function>{};
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(wrapped);
+    }
+
+    bool operator==(const FunctionWrapper& f) const noexcept
+    {
+        return wrapped == f.wrapped;
+    }
+
+    ReturnType operator()(Args... args) const noexcept
+    {
+        return wrapped.Invoke(std::forward<Args>(args)...);
+    }
+
+    ReturnType Invoke(Args&&... args) const noexcept
+    {
+        return wrapped.Invoke(std::forward<Args>(args)...);
+    }
+
+    ReturnType InvokeShared(SharedArgument<Args>... args) const
+    {
+        return wrapped.InvokeShared(std::forward<SharedArgument<Args>>(args)...);
+    }
+
+    bool CanShare() const noexcept
+    {
+        return wrapped.CanShare();
+    }
+};
+
+// Memory resource handing out fixed-size, cache line aligned blocks from chunks it never returns before it is
+// destroyed, meant for handler nodes: Delegate(&pool) puts each handler node into one block, so connecting and
+// disconnecting recycles blocks through a free list instead of going to malloc, and the nodes of one delegate sit
+// next to each other. Larger requests (big snapshots and callables) are passed on to upstream. Thread-safe, it can
+// back any number of delegates.
+class HandlerPoolResource : public std::pmr::memory_resource
+{
 private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
     std::mutex mtx;
-    std::vector<function_ptr> function_ptrs;
+    FreeBlock* free_blocks = nullptr;
+    std::vector<void*> chunks;
+    const std::size_t block_size;
+    const std::size_t blocks_per_chunk;
+    std::pmr::memory_resource* const upstream;
+
+    static constexpr std::size_t block_alignment = 64;
 
-    Delegate<ReturnType(Args...)>& operator+=(const function_ptr& f) noexcept
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
     {
+        if (bytes > block_size || alignment > block_alignment)
+            return upstream->allocate(bytes, alignment);
+
         std::lock_guard<std::mutex> lock(mtx);
-        function_ptrs.push_back(f);
-        return *this;
+        if (!free_blocks)
+        {
+            chunks.reserve(chunks.size() + 1);
+            auto* chunk = static_cast<unsigned char*>(upstream->allocate(block_size * blocks_per_chunk, block_alignment));
+            chunks.push_back(chunk);
+            for (std::size_t i = blocks_per_chunk; i-- > 0;)
+                free_blocks = ::new (chunk + i * block_size) FreeBlock{free_blocks};
+        }
+
+        FreeBlock* block = free_blocks;
+        free_blocks = block->next;
+        return block;
     }
 
-    void operator-=(const function_ptr& f) noexcept
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
     {
+        if (bytes > block_size || alignment > block_alignment)
+            return upstream->deallocate(p, bytes, alignment);
+
         std::lock_guard<std::mutex> lock(mtx);
-        for (auto it = function_ptrs.rbegin(); it != function_ptrs.rend(); ++it)
+        free_blocks = ::new (p) FreeBlock{free_blocks};
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    // The default block size fits a handler node of a non-instrumented delegate.
+    explicit HandlerPoolResource(std::size_t block_size = 64, std::size_t blocks_per_chunk = 256,
+                                 std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : block_size((std::max(block_size, sizeof(FreeBlock)) + block_alignment - 1) / block_alignment * block_alignment),
+          blocks_per_chunk(std::max<std::size_t>(blocks_per_chunk, 1)), upstream(upstream)
+    {
+    }
+
+    HandlerPoolResource(const HandlerPoolResource&) = delete;
+    HandlerPoolResource& operator=(const HandlerPoolResource&) = delete;
+
+    ~HandlerPoolResource() override
+    {
+        for (void* chunk : chunks)
+            upstream->deallocate(chunk, block_size * blocks_per_chunk, block_alignment);
+    }
+};
+
+// Runs tasks on behalf of Delegate::ExecuteAsync.
+class Executor
+{
+public:
+    using task_type = MoveOnlyFunctionWrapper<void(), 64>;
+
+    virtual ~Executor() = default;
+
+    virtual void Submit(task_type task) = 0;
+};
+
+// Runs every task right away on the submitting thread, mainly useful in tests.
+class InlineExecutor : public Executor
+{
+public:
+    void Submit(task_type task) override
+    {
+        task();
+    }
+};
+
+// Thread pool with one task deque per worker. Workers pop their own deque LIFO and steal from the others FIFO,
+// threads waiting for their tasks help out through TryRunOne instead of blocking.
+class WorkStealingThreadPool : public Executor
+{
+private:
+    struct alignas(64) Worker
+    {
+        std::mutex mtx;
+        std::deque<task_type> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<std::ptrdiff_t> pending = 0;
+    std::atomic<std::size_t> sleeping = 0;
+    std::atomic<std::size_t> next_worker = 0;
+    std::mutex sleep_mtx;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    static inline thread_local WorkStealingThreadPool* current_pool = nullptr;
+    static inline thread_local std::size_t current_worker = 0;
+
+    bool Pop(std::size_t index, task_type& task)
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        if (worker.tasks.empty())
+            return false;
+
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(std::size_t first, task_type& task)
+    {
+        for (std::size_t i = 0; i < workers.size(); ++i)
+        {
+            Worker& worker = *workers[(first + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mtx);
+            if (worker.tasks.empty())
+                continue;
+
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool Acquire(task_type& task)
+    {
+        const bool acquired = current_pool == this ? Pop(current_worker, task) || Steal(current_worker + 1, task)
+                                                   : Steal(next_worker.load(std::memory_order_relaxed), task);
+        if (acquired)
+            pending.fetch_sub(1);
+        return acquired;
+    }
+
+    void Run(std::size_t index)
+    {
+        current_pool = this;
+        current_worker = index;
+
+        task_type task;
+        while (true)
         {
-            if (*it == f)
+            if (Acquire(task))
             {
-                function_ptrs.erase((++it).base());
-                return;
+                task();
+                task = task_type();
+                continue;
             }
+
+            std::unique_lock<std::mutex> lock(sleep_mtx);
+            sleeping.fetch_add(1);
+            wake.wait(lock, [this] { return stopping || pending.load() > 0; });
+            sleeping.fetch_sub(1);
+            if (stopping && pending.load() <= 0)
+                return;
         }
     }
 
 public:
-    Delegate() {}
+    explicit WorkStealingThreadPool(std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        thread_count = std::max<std::size_t>(thread_count, 1);
+        for (std::size_t i = 0; i < thread_count; ++i)
+            workers.push_back(std::make_unique<Worker>());
+        for (std::size_t i = 0; i < thread_count; ++i)
+            threads.emplace_back([this, i] { Run(i); });
+    }
 
-    Delegate(const std::function<ReturnType(Args...)>& func)
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    ~WorkStealingThreadPool()
     {
-        function_ptrs.push_back(std::make_shared<FunctionWrapper<ReturnType(Args...)>>(func));
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads)
+            thread.join();
     }
 
-    template <typename FunctionType>
-    Delegate(const FunctionType& func)
+    static WorkStealingThreadPool& Default()
     {
-        function_ptrs.push_back(std::make_shared<FunctionWrapper<ReturnType(Args...)>>(std::function<ReturnType(Args...)>(func)));
+        static WorkStealingThreadPool pool;
+        return pool;
     }
 
-    const std::vector<function_ptr>& GetFunctionPtrs() const { return function_ptrs; }
+    std::size_t Size() const noexcept { return workers.size(); }
 
-    Delegate<ReturnType(Args...)>& operator+=(const Delegate<ReturnType(Args...)>& function)
+    // Tasks submitted from a worker go to its own deque, others are spread round-robin.
+    void Submit(task_type task) override
     {
-        for (const auto& f : function.GetFunctionPtrs())
-            *this += f;
-        return *this;
+        const std::size_t index = current_pool == this ? current_worker
+                                                       : next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        {
+            std::lock_guard<std::mutex> lock(workers[index]->mtx);
+            workers[index]->tasks.push_back(std::move(task));
+        }
+
+        pending.fetch_add(1);
+        if (sleeping.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mtx);
+            }
+            wake.notify_one();
+        }
     }
 
-    void operator-=(const Delegate<ReturnType(Args...)>& function)
+    // Runs one queued task on the calling thread, returns false if there was nothing to run.
+    bool TryRunOne()
     {
-        for (const auto& f : function.GetFunctionPtrs())
-            *this -= f;
+        task_type task;
+        if (!Acquire(task))
+            return false;
+
+        task();
+        return true;
     }
+};
 
-    std::vector<ReturnType> Execute(Args... args) noexcept
+// Result combiners for Delegate::Execute<Combiner>. Each handler's result is handed to operator() as soon as it
+// is produced, returning false stops the remaining handlers from being invoked. Result() yields the folded value.
+namespace Combiners
+{
+    template <typename T>
+    struct Collect
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        std::vector<ReturnType> results;
-        for (const auto& f : function_ptrs)
-            results.push_back((*f)(args...));
+        using result_type = std::vector<T>;
+
+        result_type results;
 
-        return results;
+        bool operator()(T&& value)
+        {
+            results.push_back(std::forward<T>(value));
+            return true;
+        }
+
+        result_type Result() { return std::move(results); }
+    };
+
+    template <typename T>
+    struct First
+    {
+        using result_type = T;
+
+        T value{};
+
+        bool operator()(T&& result)
+        {
+            value = std::forward<T>(result);
+            return false;
+        }
+
+        result_type Result() { return std::move(value); }
+    };
+
+    template <typename T>
+    struct Last
+    {
+        using result_type = T;
+
+        T value{};
+
+        bool operator()(T&& result)
+        {
+            value = std::forward<T>(result);
+            return true;
+        }
+
+        result_type Result() { return std::move(value); }
+    };
+
+    template <typename T>
+    struct OptionalLast
+    {
+        using result_type = std::optional<T>;
+
+        result_type value;
+
+        bool operator()(T&& result)
+        {
+            value = std::forward<T>(result);
+            return true;
+        }
+
+        result_type Result() { return std::move(value); }
+    };
+
+    template <typename T>
+    struct Sum
+    {
+        using result_type = T;
+
+        T value{};
+
+        bool operator()(T&& result)
+        {
+            value += std::forward<T>(result);
+            return true;
+        }
+
+        result_type Result() { return std::move(value); }
+    };
+
+    template <typename T>
+    struct Max
+    {
+        using result_type = T;
+
+        std::optional<T> value;
+
+        bool operator()(T&& result)
+        {
+            if (!value || *value < result)
+                value = std::forward<T>(result);
+            return true;
+        }
+
+        result_type Result() { return value ? std::move(*value) : T{}; }
+    };
+
+    template <typename T>
+    struct AllOf
+    {
+        using result_type = bool;
+
+        bool value = true;
+
+        bool operator()(T&& result)
+        {
+            value = static_cast<bool>(result);
+            return value;
+        }
+
+        result_type Result() { return value; }
+    };
+
+    template <typename T>
+    struct AnyOf
+    {
+        using result_type = bool;
+
+        bool value = false;
+
+        bool operator()(T&& result)
+        {
+            value = static_cast<bool>(result);
+            return !value;
+        }
+
+        result_type Result() { return value; }
+    };
+}
+
+// Log-linear latency histogram in nanoseconds: every power of two is split into 8 buckets, so a bucket is at most
+// 12.5% wide. Values from 2^40 ns (about 18 minutes) on land in the last bucket.
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t sub_bucket_bits = 3;
+    static constexpr std::size_t sub_bucket_count = std::size_t(1) << sub_bucket_bits;
+    static constexpr std::size_t bucket_count = (40 - sub_bucket_bits + 1) * sub_bucket_count;
+
+    std::array<std::uint64_t, bucket_count> counts{};
+
+    static std::size_t BucketIndex(std::uint64_t nanoseconds) noexcept
+    {
+        if (nanoseconds < sub_bucket_count)
+            return static_cast<std::size_t>(nanoseconds);
+
+        const std::size_t shift = std::bit_width(nanoseconds) - 1 - sub_bucket_bits;
+        const std::size_t index = ((shift + 1) << sub_bucket_bits) + ((nanoseconds >> shift) & (sub_bucket_count - 1));
+        return std::min(index, bucket_count - 1);
+    }
+
+    static std::uint64_t BucketLowerBound(std::size_t index) noexcept
+    {
+        if (index < sub_bucket_count)
+            return index;
+
+        const std::size_t shift = (index >> sub_bucket_bits) - 1;
+        return (sub_bucket_count + (index & (sub_bucket_count - 1))) << shift;
+    }
+
+    static std::uint64_t BucketUpperBound(std::size_t index) noexcept
+    {
+        return index + 1 < bucket_count ? BucketLowerBound(index + 1) - 1 : std::numeric_limits<std::uint64_t>::max();
+    }
+
+    std::uint64_t Count() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (std::uint64_t count : counts)
+            total += count;
+        return total;
+    }
+
+    // Upper bound of the bucket holding the given percentile (0 - 100), 0 when nothing was recorded.
+    std::chrono::nanoseconds Percentile(double percentile) const noexcept
+    {
+        const std::uint64_t total = Count();
+        if (total == 0)
+            return std::chrono::nanoseconds(0);
+
+        const double clamped = std::clamp(percentile, 0.0, 100.0);
+        const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(clamped / 100.0 * total + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::chrono::nanoseconds(static_cast<std::int64_t>(std::min<std::uint64_t>(BucketUpperBound(i), std::numeric_limits<std::int64_t>::max())));
+        }
+        return std::chrono::nanoseconds(static_cast<std::int64_t>(BucketLowerBound(bucket_count - 1)));
+    }
+};
+
+// Instrumentation policies for Delegate. The default one stores nothing and compiles to no code at all.
+struct NoInstrumentation
+{
+    static constexpr bool enabled = false;
+};
+
+// Records call count, total time and a latency histogram for every subscribed handler, see Delegate::Stats().
+struct LatencyInstrumentation
+{
+    static constexpr bool enabled = true;
+
+    struct Stats
+    {
+        std::atomic<std::uint64_t> calls = 0;
+        std::atomic<std::uint64_t> total_nanoseconds = 0;
+        std::atomic<std::uint64_t> max_nanoseconds = 0;
+        std::array<std::atomic<std::uint64_t>, LatencyHistogram::bucket_count> buckets{};
+
+        void Record(std::uint64_t nanoseconds) noexcept
+        {
+            calls.fetch_add(1, std::memory_order_relaxed);
+            total_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+            buckets[LatencyHistogram::BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+
+            std::uint64_t max = max_nanoseconds.load(std::memory_order_relaxed);
+            while (nanoseconds > max && !max_nanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+                ;
+        }
+    };
+
+    class Timer
+    {
+    private:
+        Stats& stats;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    public:
+        explicit Timer(Stats& stats) noexcept : stats(stats) {}
+
+        ~Timer()
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            stats.Record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    };
+};
+
+template <typename FunctionType, typename Instrumentation = NoInstrumentation>
+class Delegate;
+
+template <typename FunctionType>
+class ShardedDelegate;
+
+// Handlers are invoked highest priority first and in subscription order within one priority, the default is 0.
+template <typename FunctionType>
+struct Prioritized
+{
+    FunctionType function;
+    int priority;
+};
+
+template <typename FunctionType>
+Prioritized<std::decay_t<FunctionType>> WithPriority(int priority, FunctionType&& function)
+{
+    return {std::forward<FunctionType>(function), priority};
+}
+
+// delegate += BindWeak(listener, &Listener::OnEvent) subscribes without keeping listener alive: once it dies the
+// handler is skipped and disconnected by the delegate itself.
+template <typename T, typename Method>
+struct WeakBinding
+{
+    std::weak_ptr<T> object;
+    Method method;
+};
+
+template <typename T, typename Method>
+WeakBinding<T, Method> BindWeak(std::weak_ptr<T> object, Method method)
+{
+    static_assert(std::is_member_function_pointer_v<Method>, "BindWeak takes a member function pointer");
+    return {std::move(object), method};
+}
+
+template <typename T, typename Method>
+WeakBinding<T, Method> BindWeak(const std::shared_ptr<T>& object, Method method)
+{
+    return BindWeak(std::weak_ptr<T>(object), method);
+}
+
+template <typename Instrumentation, typename ReturnType, typename... Args>
+class Delegate<ReturnType(Args...), Instrumentation>
+{
+    using function_type = MoveOnlyFunctionWrapper<ReturnType(Args...)>;
+
+    // Handler node, counting its own references: a snapshot is an array of plain node pointers, and a node keeps
+    // everything an invocation reads (the inline callable, its operations table and whether it is weakly bound)
+    // in one cache line. A handler bound through a weak_ptr also carries its target's lifetime and is skipped once
+    // the target is gone. Nodes are allocated from the delegate's memory resource and return to it themselves,
+    // since a += merge may share them with another delegate. memberships counts the delegates listing the node,
+    // once it drops to zero every fire skips the node, even one still holding a snapshot with it.
+    struct alignas(64) Handler : function_type
+    {
+        using function_type::function_type;
+
+        Handler(function_type&& f) noexcept : function_type(std::move(f)) {}
+
+        ~Handler()
+        {
+            if (lifetime)
+                std::pmr::polymorphic_allocator<>(resource).delete_object(lifetime);
+        }
+
+        std::pmr::memory_resource* resource = nullptr;
+        std::weak_ptr<void>* lifetime = nullptr;
+        mutable std::atomic<std::uint32_t> references = 0;
+        mutable std::atomic<std::uint32_t> memberships = 0;
+    };
+
+    static_assert(sizeof(Handler) == 64, "a handler node should fill exactly one cache line");
+
+    // Instrumented delegates keep each handler's statistics next to its callable.
+    struct InstrumentedFunction : Handler
+    {
+        using Handler::Handler;
+
+        mutable typename Instrumentation::Stats stats;
+    };
+
+    using handler_type = std::conditional_t<Instrumentation::enabled, InstrumentedFunction, Handler>;
+
+    friend class ShardedDelegate<ReturnType(Args...)>;
+
+    // Owning pointer to a handler node. The counts only change when connecting, disconnecting and publishing,
+    // never per invocation, a fire just holds the snapshot.
+    class HandlerPtr
+    {
+    private:
+        handler_type* node = nullptr;
+
+    public:
+        HandlerPtr() noexcept {}
+
+        // Adopts a node that nobody references yet.
+        explicit HandlerPtr(handler_type* node) noexcept : node(node)
+        {
+            node->references.store(1, std::memory_order_relaxed);
+        }
+
+        HandlerPtr(const HandlerPtr& other) noexcept : node(other.node)
+        {
+            if (node)
+                node->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        HandlerPtr(HandlerPtr&& other) noexcept : node(std::exchange(other.node, nullptr)) {}
+
+        ~HandlerPtr()
+        {
+            if (node && node->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                std::pmr::polymorphic_allocator<handler_type>(node->resource).delete_object(node);
+        }
+
+        HandlerPtr& operator=(HandlerPtr other) noexcept
+        {
+            std::swap(node, other.node);
+            return *this;
+        }
+
+        handler_type& operator*() const noexcept { return *node; }
+        handler_type* operator->() const noexcept { return node; }
+        explicit operator bool() const noexcept { return node != nullptr; }
+        bool operator==(const HandlerPtr& other) const noexcept { return node == other.node; }
+    };
+
+    using function_ptr = HandlerPtr;
+    using function_list = std::pmr::vector<function_ptr>;
+    using snapshot_ptr = std::shared_ptr<const function_list>;
+
+public:
+    using result_type = std::conditional_t<std::is_void_v<ReturnType>, void, std::vector<ReturnType>>;
+
+    // Generation-checked handle to a single subscription, disconnecting a stale handle is a no-op.
+    struct Connection
+    {
+        std::uint32_t slot = 0;
+        std::uint32_t generation = 0;
+
+        explicit operator bool() const noexcept { return generation != 0; }
+    };
+
+    // Returned by Next(). The awaiter lives in the awaiting coroutine's frame and is linked into the delegate
+    // intrusively, so waiting allocates nothing. The coroutine is resumed on the firing thread once the handlers
+    // of the next fire have run, and receives a copy of its arguments.
+    class NextAwaiter
+    {
+        friend class Delegate<ReturnType(Args...), Instrumentation>;
+
+    private:
+        Delegate<ReturnType(Args...), Instrumentation>& delegate;
+        NextAwaiter* next = nullptr;
+        std::coroutine_handle<> handle;
+        std::optional<std::tuple<std::decay_t<Args>...>> arguments;
+
+    public:
+        explicit NextAwaiter(Delegate<ReturnType(Args...), Instrumentation>& delegate) noexcept : delegate(delegate) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle = awaiting;
+            NextAwaiter* head = delegate.awaiters.load(std::memory_order_relaxed);
+            do
+                next = head;
+            while (!delegate.awaiters.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        std::tuple<std::decay_t<Args>...> await_resume() { return std::move(*arguments); }
+    };
+
+private:
+    static constexpr std::uint32_t invalid_index = std::numeric_limits<std::uint32_t>::max();
+
+    struct Entry
+    {
+        function_ptr function;
+        std::uint32_t slot;
+        int priority;
+    };
+
+    // index is the entry position while the slot is live and the next free slot once released.
+    struct Slot
+    {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    // Writers keep a slot map under mtx: entries stays sorted by descending priority and in subscription order
+    // among equal priorities, removal only leaves a tombstone. Connecting at or below the lowest priority and
+    // disconnecting are O(1), a higher priority shifts the entries behind it instead of re-sorting. Invokers never
+    // see it directly, they load an immutable snapshot which is rebuilt (and the tombstones compacted) once by the
+    // first invoker after a change that finds mtx free. An invoker never waits for mtx: while a writer holds it,
+    // fires keep running the current snapshot and leave the rebuild to a later one, skipping the handlers that
+    // have been disconnected since.
+    // No lock is held while handlers run, so handlers may connect, disconnect and fire this same delegate. A fire
+    // runs the handlers of the snapshot it started with: handlers connected meanwhile join from the next fire on,
+    // while a handler disconnected meanwhile (by itself, another handler or another thread) is not called any more,
+    // not even later in the same fire. The snapshot keeps removed handlers alive until the fire is done with it,
+    // and their destructors run without any lock held, so they may use the delegate as well.
+    // Handler nodes, their out-of-line callables, snapshots and the slot map are all allocated from resource.
+    std::pmr::memory_resource* const resource;
+    mutable std::mutex mtx;
+    mutable std::pmr::vector<Entry> entries;
+    mutable std::pmr::vector<Slot> slots;
+    mutable std::uint32_t free_slot = invalid_index;
+    mutable std::size_t tombstones = 0;
+    mutable std::atomic<bool> dirty = false;
+    mutable std::atomic<snapshot_ptr> snapshot;
+    std::atomic<std::size_t> parallel_grain_size = 4;
+    std::atomic<Executor*> executor = nullptr;
+    std::atomic<NextAwaiter*> awaiters = nullptr;
+
+    // Detaches the coroutines waiting in Next() and copies the arguments into them before the handlers get to
+    // move them, the coroutines are resumed in the order they started waiting when the guard goes away.
+    // Waiting coroutines get copies of the arguments, the handlers keep theirs.
+    static constexpr bool awaitable = (std::is_copy_constructible_v<std::decay_t<Args>> && ...);
+
+    class PendingResume
+    {
+    private:
+        NextAwaiter* resumable = nullptr;
+
+    public:
+        PendingResume(Delegate<ReturnType(Args...), Instrumentation>& delegate, Args&... args)
+        {
+            // Without copyable arguments Next() is unavailable, so there is never anybody waiting.
+            if constexpr (awaitable)
+            {
+                if (!delegate.awaiters.load(std::memory_order_relaxed))
+                    return;
+
+                NextAwaiter* waiting = delegate.awaiters.exchange(nullptr, std::memory_order_acquire);
+                while (waiting)
+                {
+                    NextAwaiter* awaiter = waiting;
+                    waiting = awaiter->next;
+                    awaiter->arguments.emplace(args...);
+                    awaiter->next = resumable;
+                    resumable = awaiter;
+                }
+            }
+        }
+
+        PendingResume(PendingResume&& pending) noexcept : resumable(std::exchange(pending.resumable, nullptr)) {}
+
+        ~PendingResume()
+        {
+            while (resumable)
+            {
+                NextAwaiter* awaiter = resumable;
+                resumable = awaiter->next;
+                awaiter->handle.resume();
+            }
+        }
+    };
+
+    Connection Insert(function_ptr f, int priority)
+    {
+        if (tombstones >= 16 && tombstones * 2 >= entries.size())
+            Compact();
+
+        std::uint32_t slot = free_slot;
+        if (slot != invalid_index)
+            free_slot = slots[slot].index;
+        else
+        {
+            slot = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({invalid_index, 1});
+        }
+
+        if (entries.empty() || entries.back().priority >= priority)
+        {
+            slots[slot].index = static_cast<std::uint32_t>(entries.size());
+            entries.push_back({std::move(f), slot, priority});
+        }
+        else
+        {
+            const auto position = std::upper_bound(entries.begin(), entries.end(), priority,
+                                                   [](int p, const Entry& entry) { return p > entry.priority; });
+            const auto index = static_cast<std::uint32_t>(position - entries.begin());
+            entries.insert(position, {std::move(f), slot, priority});
+            // A tombstone's slot is free or already reused, only the live entries own theirs.
+            for (std::size_t i = index; i < entries.size(); ++i)
+            {
+                if (entries[i].function)
+                    slots[entries[i].slot].index = static_cast<std::uint32_t>(i);
+            }
+        }
+        dirty.store(true, std::memory_order_release);
+        return {slot, slots[slot].generation};
+    }
+
+    // Hands the handler back instead of dropping it, so that it is destroyed after mtx is released: a handler's
+    // captures may well touch this delegate from their destructors. The snapshot may still list the handler, fires
+    // skip it once no delegate lists it any more.
+    [[nodiscard]] function_ptr Erase(std::uint32_t index) const noexcept
+    {
+        Entry& entry = entries[index];
+        entry.function->memberships.fetch_sub(1, std::memory_order_acq_rel);
+        Slot& slot = slots[entry.slot];
+        slot.index = free_slot;
+        if (++slot.generation == 0)
+            slot.generation = 1;
+        free_slot = entry.slot;
+        ++tombstones;
+        dirty.store(true, std::memory_order_release);
+        return std::move(entry.function);
+    }
+
+    // Drops the tombstones. Publish does so anyway, Insert also does when connecting and disconnecting go on
+    // without anyone firing in between.
+    void Compact() const noexcept
+    {
+        std::size_t live = 0;
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (!entries[i].function)
+                continue;
+
+            slots[entries[i].slot].index = static_cast<std::uint32_t>(live);
+            if (live != i)
+                entries[live] = std::move(entries[i]);
+            ++live;
+        }
+        entries.erase(entries.begin() + live, entries.end());
+        tombstones = 0;
+    }
+
+    // Erase for writers. A handler that another delegate still lists after a += merge keeps running there, so it
+    // cannot be skipped by every fire: this delegate's snapshot is rebuilt right away instead. previous takes the
+    // replaced snapshot, to be released after mtx.
+    [[nodiscard]] function_ptr Detach(std::uint32_t index, snapshot_ptr& previous) const
+    {
+        function_ptr released = Erase(index);
+        if (released->memberships.load(std::memory_order_acquire) != 0)
+            previous = Rebuild();
+        return released;
+    }
+
+    // Writers that need every change so far, like a += merge, wait for the rebuild.
+    snapshot_ptr LatestFunctionPtrs() const
+    {
+        if (dirty.load(std::memory_order_acquire))
+            Publish(true);
+        return snapshot.load(std::memory_order_acquire);
+    }
+
+    // Also disconnects the weakly bound handlers whose target has died.
+    void Publish(bool wait) const
+    {
+        snapshot_ptr previous;
+        std::vector<function_ptr> expired;
+        std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
+        if (wait)
+            lock.lock();
+        else if (!lock.try_lock())
+            return;
+        if (!dirty.load(std::memory_order_relaxed))
+            return;
+
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].function && entries[i].function->lifetime && entries[i].function->lifetime->expired())
+                expired.push_back(Erase(static_cast<std::uint32_t>(i)));
+        }
+        previous = Rebuild();
+    }
+
+    // Publishes the entries as the new snapshot under mtx and returns the one it replaces.
+    snapshot_ptr Rebuild() const
+    {
+        Compact();
+
+        auto next = std::allocate_shared<function_list>(std::pmr::polymorphic_allocator<function_list>(resource));
+        next->reserve(entries.size());
+        for (const Entry& entry : entries)
+            next->push_back(entry.function);
+
+        snapshot_ptr previous = snapshot.exchange(next->empty() ? nullptr : std::move(next), std::memory_order_acq_rel);
+        dirty.store(false, std::memory_order_release);
+        return previous;
+    }
+
+    Connection Subscribe(function_ptr f, int priority)
+    {
+        f->memberships.store(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mtx);
+        return Insert(std::move(f), priority);
+    }
+
+    // Any handler may be lent the arguments (all but the last one of a fire, every one of a batch or a parallel
+    // fire), so handlers of move-only arguments have to borrow them: taking one by value is rejected when
+    // connecting, at compile time or, for an already type-erased wrapper, by throwing std::logic_error.
+    template <typename FunctionType>
+    function_ptr MakeHandler(FunctionType&& func) const
+    {
+        std::pmr::polymorphic_allocator<handler_type> allocator(resource);
+        handler_type* node;
+        if constexpr (std::is_base_of_v<function_type, std::decay_t<FunctionType>> ||
+                      std::is_same_v<std::decay_t<FunctionType>, FunctionWrapper<ReturnType(Args...)>>)
+        {
+            if (func && !func.CanShare())
+                throw std::logic_error("Delegate: handlers must take move-only arguments by reference");
+            node = allocator.template new_object<handler_type>(std::forward<FunctionType>(func));
+        }
+        else
+        {
+            static_assert(function_type::template shareable<std::decay_t<FunctionType>>,
+                          "handlers must take move-only arguments by reference, other handlers get them as well");
+            node = allocator.template new_object<handler_type>(std::allocator_arg, resource, std::forward<FunctionType>(func));
+        }
+        node->resource = resource;
+        return function_ptr(node);
+    }
+
+    template <typename Callable, typename... Params>
+    function_ptr MakeHandler(std::in_place_type_t<Callable> in_place, Params&&... params) const
+    {
+        static_assert(function_type::template shareable<Callable>,
+                      "handlers must take move-only arguments by reference, other handlers get them as well");
+        std::pmr::polymorphic_allocator<handler_type> allocator(resource);
+        handler_type* node = allocator.template new_object<handler_type>(std::allocator_arg, resource, in_place, std::forward<Params>(params)...);
+        node->resource = resource;
+        return function_ptr(node);
+    }
+
+    template <typename FunctionType, typename T>
+    Connection SubscribeWeak(FunctionType&& func, const std::weak_ptr<T>& object, int priority)
+    {
+        function_ptr f = MakeHandler(std::forward<FunctionType>(func));
+        f->lifetime = std::pmr::polymorphic_allocator<>(resource).new_object<std::weak_ptr<void>>(object);
+        return Subscribe(std::move(f), priority);
+    }
+
+    void operator-=(const function_ptr& f)
+    {
+        snapshot_ptr previous;
+        function_ptr released;
+        std::lock_guard<std::mutex> lock(mtx);
+        for (std::size_t i = entries.size(); i-- > 0;)
+        {
+            if (entries[i].function == f)
+            {
+                released = Detach(static_cast<std::uint32_t>(i), previous);
+                return;
+            }
+        }
+    }
+
+    bool Remove(const function_type& f)
+    {
+        snapshot_ptr previous;
+        function_ptr released;
+        std::lock_guard<std::mutex> lock(mtx);
+        for (std::size_t i = entries.size(); i-- > 0;)
+        {
+            if (entries[i].function && *entries[i].function == f)
+            {
+                released = Detach(static_cast<std::uint32_t>(i), previous);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The arguments are owned by the caller's frame, every handler but the last only borrows them and the last
+    // one has them moved in.
+    static ReturnType Invoke(const handler_type& f, bool last, Args&... args) noexcept
+    {
+        if constexpr (Instrumentation::enabled)
+        {
+            const typename Instrumentation::Timer timer(f.stats);
+            if (last)
+                return f.Invoke(std::forward<Args>(args)...);
+            return f.InvokeShared(args...);
+        }
+        else
+        {
+            if (last)
+                return f.Invoke(std::forward<Args>(args)...);
+            return f.InvokeShared(args...);
+        }
+    }
+
+    // Invoke for arguments that stay with the caller, such as the events of a batch.
+    static ReturnType Lend(const handler_type& f, typename function_type::template SharedArgument<Args>... args) noexcept
+    {
+        if constexpr (Instrumentation::enabled)
+        {
+            const typename Instrumentation::Timer timer(f.stats);
+            return f.InvokeShared(std::forward<typename function_type::template SharedArgument<Args>>(args)...);
+        }
+        else
+            return f.InvokeShared(std::forward<typename function_type::template SharedArgument<Args>>(args)...);
+    }
+
+    // Runs a batch in blocks of block_size events, handler by handler within a block, so each handler's code and
+    // captures stay hot across the block. sink gets the event's index within its block, flush the block's first
+    // index and length once all handlers are done with it. The coroutines waiting in Next() receive the first event.
+    template <typename Sink, typename Flush>
+    void DispatchBatch(std::span<const std::tuple<Args...>> events, std::size_t block_size, Sink&& sink, Flush&& flush)
+    {
+        if (events.empty())
+            return;
+
+        std::optional<PendingResume> resume;
+        if constexpr (awaitable)
+        {
+            if (awaiters.load(std::memory_order_relaxed))
+            {
+                std::tuple<std::decay_t<Args>...> first(events.front());
+                std::apply([&](auto&... args) { resume.emplace(*this, args...); }, first);
+            }
+        }
+
+        const snapshot_ptr functions = GetFunctionPtrs();
+        for (std::size_t first = 0; first < events.size(); first += block_size)
+        {
+            const std::span<const std::tuple<Args...>> block = events.subspan(first, std::min(block_size, events.size() - first));
+            if (functions)
+            {
+                for (const function_ptr& f : *functions)
+                {
+                    std::shared_ptr<void> target;
+                    if (!Lock(*f, target, &dirty))
+                        continue;
+
+                    for (std::size_t i = 0; i < block.size(); ++i)
+                        std::apply([&](const auto&... args) { sink(i, [&] { return Lend(*f, args...); }); }, block[i]);
+                }
+            }
+            flush(first, block.size());
+        }
+    }
+
+    template <typename Combiner>
+    static typename Combiner::result_type Combine(const snapshot_ptr& functions, std::atomic<bool>* expired, Args&... args) noexcept
+    {
+        Combiner combiner;
+        if (!functions)
+            return combiner.Result();
+
+        if constexpr (std::is_same_v<Combiner, Combiners::Collect<ReturnType>>)
+            combiner.results.reserve(functions->size());
+        Dispatch(*functions, expired, combiner, args...);
+        return combiner.Result();
+    }
+
+    static void Discard(const snapshot_ptr& functions, std::atomic<bool>* expired, Args&... args) noexcept
+    {
+        if (!functions)
+            return;
+
+        if constexpr (std::is_void_v<ReturnType>)
+            Dispatch(*functions, expired, [] { return true; }, args...);
+        else
+            Dispatch(*functions, expired, [](ReturnType&&) { return true; }, args...);
+    }
+
+    // Skips a handler that has been disconnected since the snapshot was taken. Keeps a weakly bound handler's
+    // target alive for the call, or flags the delegate for compaction (through the dirty flag, so no lock is taken
+    // here) when the target has died.
+    static bool Lock(const handler_type& f, std::shared_ptr<void>& target, std::atomic<bool>* expired) noexcept
+    {
+        if (f.memberships.load(std::memory_order_acquire) == 0)
+            return false;
+        if (!f.lifetime)
+            return true;
+
+        target = f.lifetime->lock();
+        if (target)
+            return true;
+        if (expired)
+            expired->store(true, std::memory_order_release);
+        return false;
+    }
+
+    // The task owns copies of the arguments (moved in where the caller handed them over) and lends them to the
+    // handlers, since the caller's frame is gone by the time they run.
+    template <typename Run>
+    auto Async(Run run, Args&&... args)
+    {
+        static_assert((std::is_constructible_v<std::decay_t<Args>, Args&&> && ...),
+                      "ExecuteAsync keeps its own copies of the arguments, which must be copy or move constructible");
+
+        using value_type = std::invoke_result_t<Run&, const snapshot_ptr&, Args&...>;
+
+        std::promise<value_type> promise;
+        std::future<value_type> future = promise.get_future();
+        PendingResume resume(*this, args...);
+        Executor* target = executor.load(std::memory_order_acquire);
+        (target ? *target : WorkStealingThreadPool::Default()).Submit(
+            [run, functions = GetFunctionPtrs(), promise = std::move(promise), resume = std::move(resume),
+             arguments = std::tuple<std::decay_t<Args>...>(std::forward<Args>(args)...)]() mutable
+            {
+                std::apply([&](auto&... unpacked)
+                {
+                    if constexpr (std::is_void_v<value_type>)
+                    {
+                        run(functions, unpacked...);
+                        promise.set_value();
+                    }
+                    else
+                        promise.set_value(run(functions, unpacked...));
+                }, arguments);
+                PendingResume resumed = std::move(resume);
+            });
+        return future;
+    }
+
+    // Invokes the live handlers in order, passing each result to sink until it returns false (then returns false
+    // as well). Without MoveLast even the last handler only borrows the arguments, as more handlers follow.
+    template <bool MoveLast = true, typename Sink>
+    static bool Dispatch(const function_list& functions, std::atomic<bool>* expired, Sink&& sink, Args&... args)
+    {
+        const std::size_t last = functions.size() - 1;
+        for (std::size_t i = 0; i < functions.size(); ++i)
+        {
+            std::shared_ptr<void> target;
+            if (!Lock(*functions[i], target, expired))
+                continue;
+
+            if constexpr (std::is_void_v<ReturnType>)
+            {
+                Invoke(*functions[i], MoveLast && i == last, args...);
+                if (!sink())
+                    return false;
+            }
+            else if (!sink(Invoke(*functions[i], MoveLast && i == last, args...)))
+                return false;
+        }
+        return true;
+    }
+
+public:
+    Delegate() : Delegate(std::pmr::get_default_resource()) {}
+
+    // Allocates everything from resource, e.g. a HandlerPoolResource or a per-frame arena. The resource must
+    // outlive the delegate, and every snapshot or handler still held elsewhere (an async fan-out, a += merge).
+    explicit Delegate(std::pmr::memory_resource* resource) : resource(resource), entries(resource), slots(resource) {}
+
+    Delegate(const std::function<ReturnType(Args...)>& func) : Delegate()
+    {
+        Subscribe(MakeHandler(func), 0);
+    }
+
+    // Takes the callable over the way Connect does: rvalues are moved, so move-only callables work.
+    template <typename FunctionType,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<FunctionType>, Delegate<ReturnType(Args...), Instrumentation>> &&
+                                          std::is_constructible_v<function_type, FunctionType>>>
+    Delegate(FunctionType&& func) : Delegate()
+    {
+        Subscribe(MakeHandler(std::forward<FunctionType>(func)), 0);
+    }
+
+    // The snapshot to fire, rebuilt first if that does not mean waiting for a writer.
+    snapshot_ptr GetFunctionPtrs() const
+    {
+        if (dirty.load(std::memory_order_acquire))
+            Publish(false);
+        return snapshot.load(std::memory_order_acquire);
+    }
+
+    template <typename FunctionType,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<FunctionType>, Delegate<ReturnType(Args...), Instrumentation>> &&
+                                          std::is_constructible_v<function_type, FunctionType>>>
+    Connection Connect(FunctionType&& func, int priority = 0)
+    {
+        return Subscribe(MakeHandler(std::forward<FunctionType>(func)), priority);
+    }
+
+    template <typename FunctionType,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<FunctionType>, Delegate<ReturnType(Args...), Instrumentation>> &&
+                                          std::is_constructible_v<function_type, FunctionType>>>
+    Connection operator+=(FunctionType&& func)
+    {
+        return Connect(std::forward<FunctionType>(func));
+    }
+
+    // Constructs a Callable from params directly inside the handler, e.g. Emplace<Session>(std::move(socket)).
+    template <typename Callable, typename... Params>
+    Connection Emplace(Params&&... params)
+    {
+        return Subscribe(MakeHandler(std::in_place_type<Callable>, std::forward<Params>(params)...), 0);
+    }
+
+    // delegate += WithPriority(10, handler) runs handler before every handler of a lower priority.
+    template <typename FunctionType>
+    Connection operator+=(Prioritized<FunctionType>&& prioritized)
+    {
+        return Connect(std::move(prioritized.function), prioritized.priority);
+    }
+
+    // Once this returns, no fire calls the handler any more, not even one that is already under way. A call that
+    // has already started on another thread may still be running.
+    bool Disconnect(Connection connection) noexcept
+    {
+        snapshot_ptr previous;
+        function_ptr released;
+        std::lock_guard<std::mutex> lock(mtx);
+        if (connection.slot >= slots.size() || slots[connection.slot].generation != connection.generation)
+            return false;
+
+        released = Detach(slots[connection.slot].index, previous);
+        return true;
+    }
+
+    void operator-=(Connection connection) noexcept
+    {
+        Disconnect(connection);
+    }
+
+    // Subscribes a member function or free function without a capturing lambda, e.g. Bind<&Foo::OnEvent>(foo).
+    template <auto Method, typename T>
+    Connection Bind(T& object, int priority = 0)
+    {
+        return Connect(function_type::template Bind<Method>(object), priority);
+    }
+
+    template <auto Function>
+    Connection Bind(int priority = 0)
+    {
+        return Connect(function_type::template Bind<Function>(), priority);
+    }
+
+    // Like Bind, but only holds a weak_ptr to the object: the handler is skipped from the moment the object dies and
+    // gets disconnected on the next fire. Binding an expired object returns a connection that is never connected.
+    template <auto Method, typename T>
+    Connection BindWeak(const std::weak_ptr<T>& object, int priority = 0)
+    {
+        const std::shared_ptr<T> target = object.lock();
+        if (!target)
+            return {};
+
+        return SubscribeWeak(function_type::template Bind<Method>(*target), object, priority);
+    }
+
+    template <auto Method, typename T>
+    Connection BindWeak(const std::shared_ptr<T>& object, int priority = 0)
+    {
+        if (!object)
+            return {};
+
+        return SubscribeWeak(function_type::template Bind<Method>(*object), std::weak_ptr<T>(object), priority);
+    }
+
+    template <typename T, typename Method>
+    Connection operator+=(WeakBinding<T, Method>&& binding)
+    {
+        const std::shared_ptr<T> target = binding.object.lock();
+        if (!target)
+            return {};
+
+        auto forward = [object = target.get(), method = binding.method](auto&&... params) -> ReturnType
+        {
+            return static_cast<ReturnType>(std::invoke(method, object, std::forward<decltype(params)>(params)...));
+        };
+        return SubscribeWeak(std::move(forward), binding.object, 0);
+    }
+
+    // Removes the most recent identical binding, no connection handle needed.
+    template <auto Method, typename T>
+    bool Unbind(T& object)
+    {
+        return Remove(function_type::template Bind<Method>(object));
+    }
+
+    template <auto Function>
+    bool Unbind()
+    {
+        return Remove(function_type::template Bind<Function>());
+    }
+
+    void operator-=(const function_type& f)
+    {
+        Remove(f);
+    }
+
+    void operator-=(const FunctionWrapper<ReturnType(Args...)>& f)
+    {
+        Remove(f);
+    }
+
+    bool Connected(Connection connection) const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return connection.slot < slots.size() && slots[connection.slot].generation == connection.generation;
+    }
+
+    struct HandlerStats
+    {
+        Connection connection;
+        std::uint64_t calls = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+        LatencyHistogram latency;
+    };
+
+    // Per-handler statistics of the currently connected handlers in invocation order, only available with an
+    // enabled instrumentation policy such as Delegate<void(int), LatencyInstrumentation>.
+    std::vector<HandlerStats> Stats() const
+    {
+        static_assert(Instrumentation::enabled, "Stats() needs an instrumented delegate");
+
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<HandlerStats> stats;
+        stats.reserve(entries.size());
+        for (const Entry& entry : entries)
+        {
+            if (!entry.function)
+                continue;
+
+            const auto& recorded = entry.function->stats;
+            HandlerStats& handler = stats.emplace_back();
+            handler.connection = {entry.slot, slots[entry.slot].generation};
+            handler.calls = recorded.calls.load(std::memory_order_relaxed);
+            handler.total = std::chrono::nanoseconds(recorded.total_nanoseconds.load(std::memory_order_relaxed));
+            handler.max = std::chrono::nanoseconds(recorded.max_nanoseconds.load(std::memory_order_relaxed));
+            for (std::size_t b = 0; b < LatencyHistogram::bucket_count; ++b)
+                handler.latency.counts[b] = recorded.buckets[b].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    // The other delegate's handlers are shared, not copied, and join at the default priority.
+    Delegate<ReturnType(Args...), Instrumentation>& operator+=(const Delegate<ReturnType(Args...), Instrumentation>& function)
+    {
+        const snapshot_ptr others = function.LatestFunctionPtrs();
+        if (!others)
+            return *this;
+
+        // A handler the other delegate has meanwhile let go of for good stays disconnected.
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto& f : *others)
+        {
+            std::uint32_t memberships = f->memberships.load(std::memory_order_relaxed);
+            while (memberships != 0 && !f->memberships.compare_exchange_weak(memberships, memberships + 1, std::memory_order_acq_rel))
+            {
+            }
+            if (memberships != 0)
+                Insert(f, 0);
+        }
+        return *this;
+    }
+
+    void operator-=(const Delegate<ReturnType(Args...), Instrumentation>& function)
+    {
+        const snapshot_ptr others = function.LatestFunctionPtrs();
+        if (!others)
+            return;
+
+        for (const auto& f : *others)
+            *this -= f;
+    }
+
+    // Delegates returning void fire without collecting anything, others collect every handler's result.
+    result_type Execute(Args... args) noexcept
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+            Fire(std::forward<Args>(args)...);
+        else
+            return Execute<Combiners::Collect>(std::forward<Args>(args)...);
+    }
+
+    // Folds the handlers' results through Combiner as they are produced, e.g. Execute<Combiners::AnyOf>(args...).
+    template <typename Combiner>
+    typename Combiner::result_type Execute(Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to combine");
+
+        PendingResume resume(*this, args...);
+        return Combine<Combiner>(GetFunctionPtrs(), &dirty, args...);
+    }
+
+    template <template <typename> class Combiner>
+    typename Combiner<ReturnType>::result_type Execute(Args... args) noexcept
+    {
+        return Execute<Combiner<ReturnType>>(std::forward<Args>(args)...);
+    }
+
+    // Collects every handler's result like Execute, into a vector allocated from results (e.g. a per-frame arena).
+    std::pmr::vector<ReturnType> ExecuteIn(std::pmr::memory_resource* results, Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to collect");
+
+        PendingResume resume(*this, args...);
+        std::pmr::vector<ReturnType> collected(results);
+        const snapshot_ptr functions = GetFunctionPtrs();
+        if (!functions)
+            return collected;
+
+        collected.reserve(functions->size());
+        Dispatch(*functions, &dirty, [&](ReturnType&& value)
+        {
+            collected.push_back(std::move(value));
+            return true;
+        }, args...);
+        return collected;
+    }
+
+    // Writes every handler's result through out and returns the iterator past the last one written.
+    template <typename OutputIt, typename = std::enable_if_t<std::output_iterator<OutputIt, ReturnType>>>
+    OutputIt ExecuteInto(OutputIt out, Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to collect");
+
+        PendingResume resume(*this, args...);
+        if (const snapshot_ptr functions = GetFunctionPtrs())
+        {
+            Dispatch(*functions, &dirty, [&](ReturnType&& value)
+            {
+                *out = std::move(value);
+                ++out;
+                return true;
+            }, args...);
+        }
+        return out;
+    }
+
+    // Fills results from the front and returns how many results the handlers produced. Every handler runs even
+    // when results is too small, the results that do not fit are dropped: a return value above results.size()
+    // means the span was truncated.
+    std::size_t ExecuteInto(std::span<ReturnType> results, Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to collect");
+
+        PendingResume resume(*this, args...);
+        std::size_t count = 0;
+        if (const snapshot_ptr functions = GetFunctionPtrs())
+        {
+            Dispatch(*functions, &dirty, [&](ReturnType&& value)
+            {
+                if (count < results.size())
+                    results[count] = std::move(value);
+                ++count;
+                return true;
+            }, args...);
+        }
+        return count;
+    }
+
+    // Replaces the contents of results, keeping its capacity: a vector reused across calls stops allocating once
+    // it has grown to the number of handlers.
+    template <typename Allocator>
+    void ExecuteInto(std::vector<ReturnType, Allocator>& results, Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to collect");
+
+        PendingResume resume(*this, args...);
+        results.clear();
+        if (const snapshot_ptr functions = GetFunctionPtrs())
+        {
+            results.reserve(functions->size());
+            Dispatch(*functions, &dirty, [&](ReturnType&& value)
+            {
+                results.push_back(std::move(value));
+                return true;
+            }, args...);
+        }
+    }
+
+    // Fires once per event, see DispatchBatch. Costs one snapshot load per batch instead of one per event.
+    void ExecuteBatch(std::span<const std::tuple<Args...>> events) noexcept
+    {
+        DispatchBatch(events, std::max<std::size_t>(events.size(), 1), [](std::size_t, auto&& invoke) { invoke(); },
+                      [](std::size_t, std::size_t) {});
+    }
+
+    // Combines the handlers' results for every event into results[i]. Every event is fired even if results is
+    // shorter than events, the combined results of the events beyond its end are dropped. A combiner that stops
+    // early only stops the handlers for its own event. The combiners live on the stack, a few KiB worth of them
+    // at a time, so a batch does not allocate beyond what the combiners themselves do.
+    template <typename Combiner = Combiners::Collect<ReturnType>>
+    void ExecuteBatch(std::span<const std::tuple<Args...>> events, std::span<typename Combiner::result_type> results) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to combine");
+
+        struct State
+        {
+            Combiner combiner;
+            bool done = false;
+        };
+
+        constexpr std::size_t block_size = std::clamp<std::size_t>(4096 / sizeof(State), 1, 256);
+        std::array<State, block_size> states;
+        DispatchBatch(events, block_size, [&](std::size_t i, auto&& invoke)
+        {
+            if (!states[i].done)
+                states[i].done = !states[i].combiner(invoke());
+        }, [&](std::size_t first, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (first + i < results.size())
+                    results[first + i] = states[i].combiner.Result();
+                states[i] = State();
+            }
+        });
+    }
+
+    template <template <typename> class Combiner>
+    void ExecuteBatch(std::span<const std::tuple<Args...>> events, std::span<typename Combiner<ReturnType>::result_type> results) noexcept
+    {
+        ExecuteBatch<Combiner<ReturnType>>(events, results);
+    }
+
+    // Invokes every handler and discards the results.
+    void Fire(Args... args) noexcept
+    {
+        PendingResume resume(*this, args...);
+        Discard(GetFunctionPtrs(), &dirty, args...);
+    }
+
+    // Runs the fan-out on an executor and returns a future of the results, the handlers connected at the time of
+    // the call are used. The handlers get the task's own copies of the arguments, even for reference parameters,
+    // so nothing the caller passed has to outlive the call (and handlers writing through a reference parameter
+    // write to the copy). Expired weak handlers are skipped but only disconnected by the next synchronous fire.
+    std::future<result_type> ExecuteAsync(Args... args)
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+        {
+            return Async([](const snapshot_ptr& functions, Args&... arguments) { Discard(functions, nullptr, arguments...); },
+                         std::forward<Args>(args)...);
+        }
+        else
+            return ExecuteAsync<Combiners::Collect>(std::forward<Args>(args)...);
+    }
+
+    template <typename Combiner>
+    std::future<typename Combiner::result_type> ExecuteAsync(Args... args)
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to combine");
+
+        return Async([](const snapshot_ptr& functions, Args&... arguments) { return Combine<Combiner>(functions, nullptr, arguments...); },
+                     std::forward<Args>(args)...);
+    }
+
+    template <template <typename> class Combiner>
+    std::future<typename Combiner<ReturnType>::result_type> ExecuteAsync(Args... args)
+    {
+        return ExecuteAsync<Combiner<ReturnType>>(std::forward<Args>(args)...);
+    }
+
+    // co_await delegate.Next() suspends the coroutine until the delegate fires next and yields the arguments as a
+    // tuple. The delegate must outlive the wait.
+    NextAwaiter Next() noexcept
+    {
+        static_assert(awaitable, "Next() yields copies of the arguments, which must be copy constructible");
+
+        return NextAwaiter(*this);
+    }
+
+    // Executor used by ExecuteAsync, WorkStealingThreadPool::Default() unless set.
+    void SetExecutor(Executor& target) noexcept
+    {
+        executor.store(&target, std::memory_order_release);
+    }
+
+    // Number of handlers ExecuteParallel hands to one task, delegates with no more handlers than this run sequentially.
+    void SetParallelGrainSize(std::size_t grain_size) noexcept
+    {
+        parallel_grain_size.store(std::max<std::size_t>(grain_size, 1), std::memory_order_relaxed);
+    }
+
+    // Fans the handlers out over WorkStealingThreadPool::Default(), the calling thread takes the first chunk and
+    // helps with the rest. Results are returned in subscription order and every handler only borrows the arguments.
+    result_type ExecuteParallel(Args... args) noexcept
+    {
+        const snapshot_ptr functions = GetFunctionPtrs();
+        const std::size_t grain_size = parallel_grain_size.load(std::memory_order_relaxed);
+        if (!functions || functions->size() <= grain_size)
+            return Execute(std::forward<Args>(args)...);
+
+        PendingResume resume(*this, args...);
+        using output_type = std::conditional_t<std::is_void_v<ReturnType>, bool, std::optional<ReturnType>>;
+        const std::size_t count = functions->size();
+        std::vector<output_type> outputs(std::is_void_v<ReturnType> ? 0 : count);
+
+        auto run = [&](std::size_t begin)
+        {
+            const std::size_t end = std::min(begin + grain_size, count);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::shared_ptr<void> target;
+                if (!Lock(*(*functions)[i], target, &dirty))
+                    continue;
+
+                if constexpr (std::is_void_v<ReturnType>)
+                    Invoke(*(*functions)[i], false, args...);
+                else
+                    outputs[i].emplace(Invoke(*(*functions)[i], false, args...));
+            }
+        };
+
+        WorkStealingThreadPool& pool = WorkStealingThreadPool::Default();
+        std::atomic<std::size_t> remaining = (count - 1) / grain_size;
+        for (std::size_t begin = grain_size; begin < count; begin += grain_size)
+        {
+            pool.Submit([&run, &remaining, begin]
+            {
+                run(begin);
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+
+        run(0);
+        while (remaining.load(std::memory_order_acquire) != 0)
+        {
+            if (!pool.TryRunOne())
+                std::this_thread::yield();
+        }
+
+        if constexpr (!std::is_void_v<ReturnType>)
+        {
+            std::vector<ReturnType> results;
+            results.reserve(count);
+            for (auto& output : outputs)
+            {
+                if (output)
+                    results.push_back(std::move(*output));
+            }
+            return results;
+        }
+    }
+
+    result_type operator()(Args... args) noexcept
+    {
+        return Execute(std::forward<Args>(args)...);
+    }
+};
+
+template <typename FunctionType, typename... Handlers>
+class StaticDelegate;
+
+// Delegate over a handler set fixed at compile time: the handlers live in a tuple and Execute is a fold over it,
+// so there is no type erasure, allocation or locking and the compiler can inline every handler. Offers the same
+// Execute/Fire/combiner interface as Delegate. Build one with MakeStaticDelegate<void(int)>(handlers...).
+template <typename ReturnType, typename... Args, typename... Handlers>
+class StaticDelegate<ReturnType(Args...), Handlers...>
+{
+    static_assert((std::is_invocable_r_v<ReturnType, Handlers&, Args...> && ...), "every handler must be callable with the signature");
+
+    template <typename T>
+    using SharedArgument = typename MoveOnlyFunctionWrapper<ReturnType(Args...)>::template SharedArgument<T>;
+
+    std::tuple<Handlers...> handlers;
+
+    // Same hand-over as Delegate: the last handler gets the arguments moved in, the others borrow them.
+    template <std::size_t Index>
+    ReturnType Invoke(Args&... args) noexcept
+    {
+        using wrapper_type = MoveOnlyFunctionWrapper<ReturnType(Args...)>;
+
+        auto& handler = std::get<Index>(handlers);
+        if constexpr (Index + 1 == sizeof...(Handlers))
+            return static_cast<ReturnType>(std::invoke(handler, std::forward<Args>(args)...));
+        else if constexpr (std::is_invocable_r_v<ReturnType, decltype(handler), SharedArgument<Args>...>)
+            return static_cast<ReturnType>(std::invoke(handler, std::forward<SharedArgument<Args>>(args)...));
+        else
+        {
+            static_assert((wrapper_type::template copyable_argument<Args> && ...),
+                          "only the last handler can take move-only arguments by value");
+            return static_cast<ReturnType>(std::invoke(handler, wrapper_type::template CopyArgument<Args>(args)...));
+        }
+    }
+
+    template <typename Sink, std::size_t... Index>
+    void Dispatch(Sink& sink, std::index_sequence<Index...>, Args&... args) noexcept
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+            (void)((Invoke<Index>(args...), sink()) && ...);
+        else
+            (void)(sink(Invoke<Index>(args...)) && ...);
+    }
+
+public:
+    using result_type = std::conditional_t<std::is_void_v<ReturnType>, void, std::vector<ReturnType>>;
+
+    constexpr explicit StaticDelegate(Handlers... handlers) : handlers(std::move(handlers)...) {}
+
+    static constexpr std::size_t Size() noexcept
+    {
+        return sizeof...(Handlers);
+    }
+
+    result_type Execute(Args... args) noexcept
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+            Fire(std::forward<Args>(args)...);
+        else
+            return Execute<Combiners::Collect>(std::forward<Args>(args)...);
+    }
+
+    template <typename Combiner>
+    typename Combiner::result_type Execute(Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to combine");
+
+        Combiner combiner;
+        if constexpr (std::is_same_v<Combiner, Combiners::Collect<ReturnType>>)
+            combiner.results.reserve(sizeof...(Handlers));
+        Dispatch(combiner, std::index_sequence_for<Handlers...>(), args...);
+        return combiner.Result();
+    }
+
+    template <template <typename> class Combiner>
+    typename Combiner<ReturnType>::result_type Execute(Args... args) noexcept
+    {
+        return Execute<Combiner<ReturnType>>(std::forward<Args>(args)...);
+    }
+
+    void Fire(Args... args) noexcept
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+        {
+            auto sink = [] { return true; };
+            Dispatch(sink, std::index_sequence_for<Handlers...>(), args...);
+        }
+        else
+        {
+            auto sink = [](ReturnType&&) { return true; };
+            Dispatch(sink, std::index_sequence_for<Handlers...>(), args...);
+        }
+    }
+
+    result_type operator()(Args... args) noexcept
+    {
+        return Execute(std::forward<Args>(args)...);
+    }
+};
+
+template <typename FunctionType, typename... Handlers>
+constexpr StaticDelegate<FunctionType, std::decay_t<Handlers>...> MakeStaticDelegate(Handlers&&... handlers)
+{
+    return StaticDelegate<FunctionType, std::decay_t<Handlers>...>(std::forward<Handlers>(handlers)...);
+}
+
+// Numbers threads in the order they first connect to a ShardedDelegate of any signature. Lives outside the
+// template so that all instantiations share a single count and spread the threads over their shards the same way.
+inline std::size_t ShardThreadIndex() noexcept
+{
+    static std::atomic<std::size_t> next_thread = 0;
+    static thread_local const std::size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+    return thread_index;
+}
+
+// Delegate split into cache-line aligned shards for heavy subscription churn from many threads: a thread always
+// connects to its own shard, so concurrent Connect/Disconnect calls rarely meet on the same mutex. Execute walks
+// the shards in index order, so handlers run in priority and subscription order per shard but not across shards:
+// every handler of shard 0 runs before any handler of shard 1, whatever their priorities. Invoking costs one
+// snapshot load per shard, plain Delegate stays the better choice for delegates that mostly fire.
+template <typename ReturnType, typename... Args>
+class ShardedDelegate<ReturnType(Args...)>
+{
+    using delegate_type = Delegate<ReturnType(Args...)>;
+
+    struct alignas(64) Shard
+    {
+        delegate_type delegate;
+    };
+
+    const std::size_t shard_count;
+    const std::unique_ptr<Shard[]> shards;
+
+    // Threads are dealt out to the shards round-robin in the order they first connect to any sharded delegate.
+    std::size_t LocalShard() const noexcept
+    {
+        return ShardThreadIndex() % shard_count;
+    }
+
+    template <typename Sink>
+    void Dispatch(Sink&& sink, Args&... args) noexcept
+    {
+        for (std::size_t i = 0; i < shard_count; ++i)
+        {
+            delegate_type& delegate = shards[i].delegate;
+            const typename delegate_type::snapshot_ptr functions = delegate.GetFunctionPtrs();
+            if (!functions)
+                continue;
+
+            const bool finished = i + 1 == shard_count
+                                      ? delegate_type::Dispatch(*functions, &delegate.dirty, sink, args...)
+                                      : delegate_type::template Dispatch<false>(*functions, &delegate.dirty, sink, args...);
+            if (!finished)
+                return;
+        }
+    }
+
+public:
+    using result_type = typename delegate_type::result_type;
+
+    struct Connection
+    {
+        std::size_t shard = 0;
+        typename delegate_type::Connection connection;
+    };
+
+    explicit ShardedDelegate(std::size_t shard_count = std::thread::hardware_concurrency())
+        : shard_count(std::max<std::size_t>(shard_count, 1)), shards(std::make_unique<Shard[]>(this->shard_count))
+    {
+    }
+
+    ShardedDelegate(const ShardedDelegate&) = delete;
+    ShardedDelegate& operator=(const ShardedDelegate&) = delete;
+
+    std::size_t ShardCount() const noexcept
+    {
+        return shard_count;
+    }
+
+    // priority only orders the handler among those of the calling thread's shard, not across the whole delegate.
+    template <typename FunctionType>
+    Connection Connect(FunctionType&& func, int priority = 0)
+    {
+        const std::size_t shard = LocalShard();
+        return {shard, shards[shard].delegate.Connect(std::forward<FunctionType>(func), priority)};
+    }
+
+    template <typename FunctionType>
+    Connection operator+=(FunctionType&& func)
+    {
+        return Connect(std::forward<FunctionType>(func));
+    }
+
+    // Can be called from any thread, it only locks the shard the handler was connected to.
+    bool Disconnect(Connection connection) noexcept
+    {
+        return connection.shard < shard_count && shards[connection.shard].delegate.Disconnect(connection.connection);
+    }
+
+    void operator-=(Connection connection) noexcept
+    {
+        Disconnect(connection);
+    }
+
+    bool Connected(Connection connection) const noexcept
+    {
+        return connection.shard < shard_count && shards[connection.shard].delegate.Connected(connection.connection);
+    }
+
+    result_type Execute(Args... args) noexcept
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+            Fire(std::forward<Args>(args)...);
+        else
+            return Execute<Combiners::Collect>(std::forward<Args>(args)...);
+    }
+
+    // The combiner sees the results of all shards and can stop the walk early.
+    template <typename Combiner>
+    typename Combiner::result_type Execute(Args... args) noexcept
+    {
+        static_assert(!std::is_void_v<ReturnType>, "void delegates have no results to combine");
+
+        Combiner combiner;
+        Dispatch(combiner, args...);
+        return combiner.Result();
+    }
+
+    template <template <typename> class Combiner>
+    typename Combiner<ReturnType>::result_type Execute(Args... args) noexcept
+    {
+        return Execute<Combiner<ReturnType>>(std::forward<Args>(args)...);
+    }
+
+    void Fire(Args... args) noexcept
+    {
+        if constexpr (std::is_void_v<ReturnType>)
+            Dispatch([] { return true; }, args...);
+        else
+            Dispatch([](ReturnType&&) { return true; }, args...);
+    }
+
+    result_type operator()(Args... args) noexcept
+    {
+        return Execute(std::forward<Args>(args)...);
+    }
+};
+
+template <typename FunctionType>
+class DelegateRef;
+
+// Non-owning, trivially copyable view of a callable: an object pointer plus a thunk, so binding never allocates.
+// Meant for callback parameters, the referenced callable must outlive the view.
+template <typename ReturnType, typename... Args>
+class DelegateRef<ReturnType(Args...)>
+{
+private:
+    union Target
+    {
+        void* object;
+        void (*function)();
+    };
+
+    Target target;
+    ReturnType (*thunk)(Target target, Args&&... args);
+
+    DelegateRef(Target target, ReturnType (*thunk)(Target, Args&&...)) noexcept : target(target), thunk(thunk) {}
+
+public:
+    template <typename Result, typename... Params,
+              typename = std::enable_if_t<std::is_invocable_r_v<ReturnType, Result (*)(Params...), Args...>>>
+    DelegateRef(Result (*function)(Params...)) noexcept
+    {
+        target.function = reinterpret_cast<void (*)()>(function);
+        thunk = [](Target target, Args&&... args) -> ReturnType
+        {
+            const auto f = reinterpret_cast<Result (*)(Params...)>(target.function);
+            if constexpr (std::is_void_v<ReturnType>)
+                f(std::forward<Args>(args)...);
+            else
+                return f(std::forward<Args>(args)...);
+        };
+    }
+
+    template <typename FunctionType,
+              typename Callable = std::remove_reference_t<FunctionType>,
+              typename = std::enable_if_t<!std::is_same_v<std::remove_cv_t<Callable>, DelegateRef> &&
+                                          !std::is_function_v<Callable> &&
+                                          std::is_invocable_r_v<ReturnType, Callable&, Args...>>>
+    DelegateRef(FunctionType&& f) noexcept
+    {
+        target.object = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+        thunk = [](Target target, Args&&... args) -> ReturnType
+        {
+            Callable& callable = *static_cast<Callable*>(target.object);
+            if constexpr (std::is_void_v<ReturnType>)
+                std::invoke(callable, std::forward<Args>(args)...);
+            else
+                return std::invoke(callable, std::forward<Args>(args)...);
+        };
+    }
+
+    // A whole delegate bound to a void view is fired without collecting its results.
+    template <typename DelegateReturnType, typename Instrumentation, typename Result = ReturnType,
+              typename = std::enable_if_t<std::is_void_v<Result>>>
+    DelegateRef(Delegate<DelegateReturnType(Args...), Instrumentation>& delegate) noexcept
+    {
+        target.object = &delegate;
+        thunk = [](Target target, Args&&... args)
+        {
+            static_cast<Delegate<DelegateReturnType(Args...), Instrumentation>*>(target.object)->Fire(std::forward<Args>(args)...);
+        };
+    }
+
+    // The bound member function or free function is part of the thunk, only the object pointer is stored.
+    template <auto Method, typename T>
+    static DelegateRef<ReturnType(Args...)> Bind(T& object) noexcept
+    {
+        static_assert(std::is_invocable_r_v<ReturnType, decltype(Method), T*, Args...>, "Method cannot be called with these arguments");
+
+        Target target;
+        target.object = const_cast<void*>(static_cast<const void*>(std::addressof(object)));
+        return DelegateRef<ReturnType(Args...)>(target, [](Target target, Args&&... args) -> ReturnType
+        {
+            return static_cast<ReturnType>(std::invoke(Method, static_cast<T*>(target.object), std::forward<Args>(args)...));
+        });
+    }
+
+    template <auto Function>
+    static DelegateRef<ReturnType(Args...)> Bind() noexcept
+    {
+        static_assert(std::is_invocable_r_v<ReturnType, decltype(Function), Args...>, "Function cannot be called with these arguments");
+
+        Target target;
+        target.object = nullptr;
+        return DelegateRef<ReturnType(Args...)>(target, [](Target, Args&&... args) -> ReturnType
+        {
+            return static_cast<ReturnType>(std::invoke(Function, std::forward<Args>(args)...));
+        });
+    }
+
+    ReturnType operator()(Args... args) const noexcept
+    {
+        return thunk(target, std::forward<Args>(args)...);
+    }
+};
+
+template <typename FunctionType>
+class QueuedDelegate;
+
+// Deferred dispatch: producers Post the arguments into a pre-allocated ring buffer without taking a lock or
+// allocating, one consumer thread drains it with Pump and fires the target delegate once per event.
+template <typename ReturnType, typename... Args>
+class QueuedDelegate<ReturnType(Args...)>
+{
+    using event_type = std::tuple<std::decay_t<Args>...>;
+
+private:
+    // A cell is free for the producer claiming position p when sequence == p, and holds an event for the consumer
+    // when sequence == p + 1.
+    struct alignas(64) Cell
+    {
+        std::atomic<std::size_t> sequence;
+        alignas(event_type) unsigned char storage[sizeof(event_type)];
+
+        event_type& Event() noexcept { return *std::launder(reinterpret_cast<event_type*>(storage)); }
+    };
+
+    DelegateRef<void(Args...)> target;
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> enqueue_position = 0;
+    alignas(64) std::size_t dequeue_position = 0;
+
+public:
+    // capacity is rounded up to a power of two.
+    template <typename Instrumentation>
+    explicit QueuedDelegate(Delegate<ReturnType(Args...), Instrumentation>& target, std::size_t capacity = 1024) : target(target)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        cells = std::make_unique<Cell[]>(size);
+        mask = size - 1;
+        for (std::size_t i = 0; i < size; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    QueuedDelegate(const QueuedDelegate&) = delete;
+    QueuedDelegate& operator=(const QueuedDelegate&) = delete;
+
+    ~QueuedDelegate()
+    {
+        while (true)
+        {
+            Cell& cell = cells[dequeue_position & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+                break;
+
+            cell.Event().~event_type();
+            ++dequeue_position;
+        }
+    }
+
+    std::size_t Capacity() const noexcept { return mask + 1; }
+
+    // Safe to call from any number of threads, never blocks. Returns false (and drops the event) when the ring is full.
+    bool Post(Args... args)
+    {
+        std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &cells[position & mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+                return false;
+            else
+                position = enqueue_position.load(std::memory_order_relaxed);
+        }
+
+        ::new (static_cast<void*>(cell->storage)) event_type(std::forward<Args>(args)...);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, must only be called from one thread at a time. Fires the target for up to max_events queued
+    // events in posting order and returns how many were dispatched.
+    std::size_t Pump(std::size_t max_events = std::numeric_limits<std::size_t>::max())
+    {
+        std::size_t dispatched = 0;
+        while (dispatched < max_events)
+        {
+            Cell& cell = cells[dequeue_position & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+                break;
+
+            event_type& event = cell.Event();
+            std::apply([this](auto&... arguments) { target(std::forward<Args>(arguments)...); }, event);
+            event.~event_type();
+            cell.sequence.store(dequeue_position + mask + 1, std::memory_order_release);
+            ++dequeue_position;
+            ++dispatched;
+        }
+        return dispatched;
+    }
+};
+
+// One Delegate<void(const Event&)> per event type. Every event type gets a dense index the first time any bus sees
+// it (no RTTI, no hashing), Publish finds its channel with a single array lookup in a lock-free snapshot.
+class EventBus
+{
+private:
+    struct ChannelBase
+    {
+        virtual ~ChannelBase() = default;
+    };
+
+    template <typename Event>
+    struct Channel : ChannelBase
+    {
+        Delegate<void(const Event&)> delegate;
+    };
+
+    using directory_type = std::vector<ChannelBase*>;
+
+    std::mutex mtx;
+    std::vector<std::unique_ptr<ChannelBase>> channels;
+    std::atomic<std::shared_ptr<const directory_type>> directory;
+
+    static std::size_t NextTypeIndex() noexcept
+    {
+        static std::atomic<std::size_t> next = 0;
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename Event>
+    static std::size_t TypeIndex() noexcept
+    {
+        static const std::size_t index = NextTypeIndex();
+        return index;
+    }
+
+    template <typename Event>
+    Channel<Event>* Find() const noexcept
+    {
+        const std::size_t index = TypeIndex<Event>();
+        const std::shared_ptr<const directory_type> current = directory.load(std::memory_order_acquire);
+        if (!current || index >= current->size())
+            return nullptr;
+        return static_cast<Channel<Event>*>((*current)[index]);
+    }
+
+public:
+    template <typename Event>
+    using connection_type = typename Delegate<void(const Event&)>::Connection;
+
+    EventBus() {}
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    // The delegate carrying events of the given type, created on first use. It lives as long as the bus.
+    template <typename Event>
+    Delegate<void(const Event&)>& Events()
+    {
+        static_assert(std::is_same_v<Event, std::decay_t<Event>>, "event types are plain object types");
+
+        if (Channel<Event>* channel = Find<Event>())
+            return channel->delegate;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        const std::size_t index = TypeIndex<Event>();
+        const std::shared_ptr<const directory_type> current = directory.load(std::memory_order_relaxed);
+        if (current && index < current->size() && (*current)[index])
+            return static_cast<Channel<Event>*>((*current)[index])->delegate;
+
+        auto next = current ? std::make_shared<directory_type>(*current) : std::make_shared<directory_type>();
+        if (next->size() <= index)
+            next->resize(index + 1, nullptr);
+
+        auto channel = std::make_unique<Channel<Event>>();
+        Channel<Event>* created = channel.get();
+        channels.push_back(std::move(channel));
+        (*next)[index] = created;
+        directory.store(std::move(next), std::memory_order_release);
+        return created->delegate;
+    }
+
+    template <typename Event, typename Handler>
+    connection_type<Event> Subscribe(Handler&& handler, int priority = 0)
+    {
+        return Events<Event>().Connect(std::forward<Handler>(handler), priority);
+    }
+
+    template <typename Event>
+    bool Unsubscribe(connection_type<Event> connection) noexcept
+    {
+        Channel<Event>* channel = Find<Event>();
+        return channel && channel->delegate.Disconnect(connection);
     }
 
-    std::vector<ReturnType> operator()(Args... args) noexcept
+    // Events nobody ever subscribed to are dropped without creating a channel.
+    template <typename Event>
+    void Publish(const Event& event) noexcept
     {
-        return Execute(args...);
+        if (Channel<Event>* channel = Find<Event>())
+            channel->delegate.Fire(event);
     }
 };
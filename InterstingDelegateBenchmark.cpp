@@ -0,0 +1,407 @@
+// Benchmarks for InterstingDelegate.hpp, self-contained so it builds without any framework:
+//     g++ -std=c++20 -O2 -pthread InterstingDelegateBenchmark.cpp -o delegate_benchmark
+// Pass a substring as the first argument to only run the matching benchmarks.
+
+#include "InterstingDelegate.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counting allocations replaces the global operator new/delete pair, which GCC mistakes for a mismatch.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::size_t> allocation_count = 0;
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// std::pmr::new_delete_resource allocates through the aligned forms.
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+static const char* filter = nullptr;
+
+// Runs body(iterations) with a doubling iteration count until it takes at least 200ms, then reports the time and
+// the number of heap allocations per iteration.
+template <typename Body>
+void Benchmark(const std::string& name, Body&& body)
+{
+    if (filter && name.find(filter) == std::string::npos)
+        return;
+
+    using clock = std::chrono::steady_clock;
+    std::size_t iterations = 1;
+    while (true)
+    {
+        const std::size_t allocations = allocation_count.load(std::memory_order_relaxed);
+        const auto start = clock::now();
+        body(iterations);
+        const double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        const std::size_t allocated = allocation_count.load(std::memory_order_relaxed) - allocations;
+
+        if (elapsed >= 2e8 || iterations >= (std::size_t(1) << 30))
+        {
+            std::printf("%-48s %12.2f ns %12zu %10.2f allocs/op\n",
+                        name.c_str(), elapsed / iterations, iterations, double(allocated) / iterations);
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+static int counter = 0;
+
+void FreeHandler(int x) { counter += x; }
+
+struct VirtualHandler
+{
+    virtual ~VirtualHandler() = default;
+    virtual void Handle(int x) = 0;
+};
+
+struct CountingHandler : VirtualHandler
+{
+    void Handle(int x) override { counter += x; }
+};
+
+struct Listener
+{
+    int total = 0;
+    void OnEvent(int x) { total += x; }
+};
+
+struct LargePayload
+{
+    char bytes[4096] = {};
+};
+
+static void InvocationBenchmarks()
+{
+    for (std::size_t handlers : {1, 8, 64, 1024})
+    {
+        const std::string suffix = "/" + std::to_string(handlers);
+
+        std::vector<void (*)(int)> pointers(handlers, &FreeHandler);
+        Benchmark("FunctionPointer" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                for (auto f : pointers)
+                    f(1);
+            DoNotOptimize(counter);
+        });
+
+        std::vector<std::unique_ptr<VirtualHandler>> objects;
+        for (std::size_t i = 0; i < handlers; ++i)
+            objects.push_back(std::make_unique<CountingHandler>());
+        Benchmark("VirtualCall" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                for (auto& object : objects)
+                    object->Handle(1);
+            DoNotOptimize(counter);
+        });
+
+        std::vector<std::function<void(int)>> functions(handlers, [](int x) { counter += x; });
+        Benchmark("StdFunction" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                for (auto& f : functions)
+                    f(1);
+            DoNotOptimize(counter);
+        });
+
+        Delegate<void(int)> notify;
+        for (std::size_t i = 0; i < handlers; ++i)
+            notify += [](int x) { counter += x; };
+        Benchmark("Delegate<void>::Fire" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                notify.Fire(1);
+            DoNotOptimize(counter);
+        });
+
+        Delegate<int(int)> query;
+        for (std::size_t i = 0; i < handlers; ++i)
+            query += [](int x) { return x + 1; };
+        Benchmark("Delegate<int>::Execute" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                DoNotOptimize(query.Execute(1));
+        });
+        std::vector<int> results;
+        Benchmark("Delegate<int>::ExecuteInto(vector)" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                query.ExecuteInto(results, 1);
+            DoNotOptimize(results.data());
+        });
+        Benchmark("Delegate<int>::Execute<Sum>" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                DoNotOptimize(query.Execute<Combiners::Sum>(1));
+        });
+
+        std::vector<Listener> listeners(handlers);
+        Delegate<void(int)> bound;
+        for (auto& listener : listeners)
+            bound.Bind<&Listener::OnEvent>(listener);
+        Benchmark("Delegate<void>::Fire(Bind)" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                bound.Fire(1);
+            DoNotOptimize(listeners.front().total);
+        });
+    }
+
+    auto handler = [](int x) { counter += x; };
+    auto fixed = MakeStaticDelegate<void(int)>(handler, handler, handler, handler, handler, handler, handler, handler);
+    Benchmark("StaticDelegate<void>::Fire/8", [&](std::size_t n)
+    {
+        // Everything inlines here, so keep the compiler from folding the iterations together.
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            fixed.Fire(1);
+            DoNotOptimize(counter);
+        }
+    });
+}
+
+static void SubscriptionBenchmarks()
+{
+    for (std::size_t handlers : {8, 1024})
+    {
+        const std::string suffix = "/" + std::to_string(handlers);
+        std::vector<Delegate<void(int)>::Connection> connections(handlers);
+
+        Benchmark("Connect+Disconnect" + suffix, [&](std::size_t n)
+        {
+            Delegate<void(int)> delegate;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (auto& connection : connections)
+                    connection = delegate += [](int x) { counter += x; };
+                for (auto& connection : connections)
+                    delegate -= connection;
+            }
+        });
+
+        HandlerPoolResource pool;
+        Benchmark("Connect+Disconnect(HandlerPoolResource)" + suffix, [&](std::size_t n)
+        {
+            Delegate<void(int)> delegate(&pool);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (auto& connection : connections)
+                    connection = delegate += [](int x) { counter += x; };
+                for (auto& connection : connections)
+                    delegate -= connection;
+            }
+        });
+
+        std::vector<Listener> listeners(handlers);
+        Benchmark("Bind+Unbind" + suffix, [&](std::size_t n)
+        {
+            Delegate<void(int)> delegate;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (auto& listener : listeners)
+                    delegate.Bind<&Listener::OnEvent>(listener);
+                for (auto& listener : listeners)
+                    delegate.Unbind<&Listener::OnEvent>(listener);
+            }
+        });
+
+        Benchmark("Connect+Fire+Disconnect" + suffix, [&](std::size_t n)
+        {
+            Delegate<void(int)> delegate;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (auto& connection : connections)
+                    connection = delegate += [](int x) { counter += x; };
+                delegate.Fire(1);
+                for (auto& connection : connections)
+                    delegate -= connection;
+            }
+            DoNotOptimize(counter);
+        });
+    }
+}
+
+static void ContentionBenchmarks()
+{
+    Delegate<void(int)> delegate;
+    std::atomic<int> total = 0;
+    for (int i = 0; i < 8; ++i)
+        delegate += [&total](int x) { total.fetch_add(x, std::memory_order_relaxed); };
+
+    for (std::size_t threads : {1, 2, 4, 8, 16, 32, 64})
+    {
+        // Reports the wall time per fire with every thread firing n times.
+        Benchmark("ConcurrentFire/threads:" + std::to_string(threads), [&](std::size_t n)
+        {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&]
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                        delegate.Fire(1);
+                });
+            }
+            for (auto& worker : workers)
+                worker.join();
+        });
+    }
+
+    for (std::size_t threads : {1, 8, 64})
+    {
+        // Every thread connects and disconnects n handlers of its own.
+        Delegate<void(int)> shared;
+        Benchmark("ConcurrentConnect/threads:" + std::to_string(threads), [&](std::size_t n)
+        {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&]
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                        shared -= shared += [](int x) { counter += x; };
+                });
+            }
+            for (auto& worker : workers)
+                worker.join();
+        });
+
+        ShardedDelegate<void(int)> sharded(threads);
+        Benchmark("ConcurrentConnect(ShardedDelegate)/threads:" + std::to_string(threads), [&](std::size_t n)
+        {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&]
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                        sharded -= sharded += [](int x) { counter += x; };
+                });
+            }
+            for (auto& worker : workers)
+                worker.join();
+        });
+    }
+}
+
+static void PayloadBenchmarks()
+{
+    for (std::size_t handlers : {1, 16})
+    {
+        const std::string suffix = "/" + std::to_string(handlers);
+        LargePayload payload;
+
+        Delegate<void(LargePayload)> by_value;
+        for (std::size_t i = 0; i < handlers; ++i)
+            by_value += [](const LargePayload& p) { counter += p.bytes[0]; };
+        Benchmark("Fire(LargePayload)" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                by_value.Fire(payload);
+            DoNotOptimize(counter);
+        });
+
+        Delegate<void(const LargePayload&)> by_reference;
+        for (std::size_t i = 0; i < handlers; ++i)
+            by_reference += [](const LargePayload& p) { counter += p.bytes[0]; };
+        Benchmark("Fire(const LargePayload&)" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                by_reference.Fire(payload);
+            DoNotOptimize(counter);
+        });
+
+        const std::string text(256, 'x');
+        Delegate<void(std::string)> strings;
+        for (std::size_t i = 0; i < handlers; ++i)
+            strings += [](const std::string& s) { counter += static_cast<int>(s.size()); };
+        Benchmark("Fire(std::string)" + suffix, [&](std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                strings.Fire(text);
+            DoNotOptimize(counter);
+        });
+    }
+}
+
+static void BatchBenchmarks()
+{
+    Delegate<int(int)> query;
+    for (int i = 0; i < 8; ++i)
+        query += [i](int x) { return x + i; };
+
+    // Both report the time per event of a 4096 event batch.
+    std::vector<std::tuple<int>> events(4096, std::tuple<int>(1));
+    std::vector<int> sums(events.size());
+    Benchmark("Execute<Sum>/events:4096", [&](std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            sums[i % events.size()] = query.Execute<Combiners::Sum>(std::get<0>(events[i % events.size()]));
+        DoNotOptimize(sums.data());
+    });
+    Benchmark("ExecuteBatch<Sum>/events:4096", [&](std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i += events.size())
+            query.ExecuteBatch<Combiners::Sum>(events, std::span(sums));
+        DoNotOptimize(sums.data());
+    });
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        filter = argv[1];
+
+    std::printf("%-48s %15s %12s %20s\n", "Benchmark", "Time", "Iterations", "Allocations");
+    InvocationBenchmarks();
+    SubscriptionBenchmarks();
+    ContentionBenchmarks();
+    PayloadBenchmarks();
+    BatchBenchmarks();
+    return 0;
+}
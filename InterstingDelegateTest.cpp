@@ -0,0 +1,631 @@
+// Regression tests for InterstingDelegate.hpp, self-contained like the benchmark:
+//     g++ -std=c++20 -pthread InterstingDelegateTest.cpp -o delegate_test && ./delegate_test
+
+#include "InterstingDelegate.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory_resource>
+#include <stdexcept>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<int> failures = 0;
+
+#define CHECK(condition)                                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                                        \
+        }                                                                                      \
+    } while (false)
+
+// Inserting ahead of a tombstone must not touch the slot the tombstone used to own.
+static void PriorityInsertBehindTombstone()
+{
+    std::string log;
+    Delegate<void()> delegate;
+    const auto a = delegate.Connect([&] { log += 'a'; }, 0);
+    delegate.Connect([&] { log += 'b'; }, 0);
+    CHECK(delegate.Disconnect(a));
+
+    const auto c = delegate.Connect([&] { log += 'c'; }, 5);
+    delegate.Fire();
+    CHECK(log == "cb");
+
+    CHECK(delegate.Disconnect(c));
+    CHECK(!delegate.Connected(c));
+    log.clear();
+    delegate.Fire();
+    CHECK(log == "b");
+
+    // The freed slots are still usable afterwards.
+    const auto d = delegate.Connect([&] { log += 'd'; }, 1);
+    const auto e = delegate.Connect([&] { log += 'e'; }, 0);
+    log.clear();
+    delegate.Fire();
+    CHECK(log == "dbe");
+    CHECK(delegate.Disconnect(d) && delegate.Disconnect(e));
+}
+
+static void ConcurrentPriorityChurn()
+{
+    Delegate<void(int)> delegate;
+    std::atomic<bool> stop = false;
+    std::thread firer([&]
+    {
+        while (!stop.load())
+            delegate.Fire(1);
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t)
+    {
+        writers.emplace_back([&, t]
+        {
+            for (int i = 0; i < 2000; ++i)
+            {
+                const auto low = delegate.Connect([](int) {}, 0);
+                const auto high = delegate.Connect([](int) {}, (i + t) % 7);
+                CHECK(delegate.Disconnect(low));
+                CHECK(delegate.Disconnect(high));
+            }
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    stop.store(true);
+    firer.join();
+
+    int calls = 0;
+    delegate.Connect([&](int) { ++calls; });
+    delegate.Fire(1);
+    CHECK(calls == 1);
+}
+
+// Stalls the allocations made under a delegate's mtx (everything but the cache line aligned handler nodes) while
+// blocking is set, so a test can hold a writer inside the lock.
+class StallingResource : public std::pmr::memory_resource
+{
+public:
+    std::atomic<bool> blocking = false;
+    std::atomic<bool> holding = false;
+    std::atomic<bool> release = false;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (alignment < 64 && blocking.load())
+        {
+            holding.store(true);
+            while (!release.load())
+                std::this_thread::yield();
+        }
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// A fire that starts after Disconnect returned never calls the handler, even while a writer holds up the rebuild.
+static void NoCallAfterDisconnect()
+{
+    StallingResource resource;
+    int calls = 0;
+    Delegate<void()> delegate(&resource);
+    const auto connection = delegate.Connect([&] { ++calls; });
+    delegate.Fire();
+    CHECK(delegate.Disconnect(connection));
+
+    resource.blocking.store(true);
+    std::thread writer([&] { delegate.Connect([] {}); });
+    while (!resource.holding.load())
+        std::this_thread::yield();
+    delegate.Fire();
+    resource.blocking.store(false);
+    resource.release.store(true);
+    writer.join();
+    CHECK(calls == 1);
+
+    // A handler shared by a += merge stops in the delegate it is disconnected from and keeps running in the other.
+    Delegate<void()> source;
+    int shared = 0;
+    const auto shared_connection = source.Connect([&] { ++shared; });
+    Delegate<void()> merged;
+    merged += source;
+    CHECK(source.Disconnect(shared_connection));
+    source.Fire();
+    merged.Fire();
+    CHECK(shared == 1);
+}
+
+// Handlers may disconnect themselves and each other, connect and fire the delegate while it fires.
+static void Reentrancy()
+{
+    std::string log;
+    Delegate<void(int)> delegate;
+    Delegate<void(int)>::Connection self, victim;
+    self = delegate.Connect([&](int) { log += 's'; delegate.Disconnect(self); });
+    delegate.Connect([&](int) { log += 'k'; delegate.Disconnect(victim); });
+    victim = delegate.Connect([&](int) { log += 'v'; });
+    delegate.Connect([&](int depth)
+    {
+        log += 'n';
+        if (depth > 0)
+        {
+            delegate.Connect([&](int) { log += 'j'; });
+            delegate.Fire(depth - 1);
+        }
+    });
+
+    // The outer fire skips the handler disconnected ahead of it and never sees the joining one, the nested fire
+    // starts from a snapshot without the disconnected handlers and with the joining one.
+    delegate.Fire(1);
+    CHECK(log == "sknknj");
+    CHECK(!delegate.Connected(self) && !delegate.Connected(victim));
+
+    log.clear();
+    delegate.Fire(0);
+    CHECK(log == "knj");
+}
+
+// A handler's destructor runs without the delegate's lock held, so it may connect and disconnect.
+static void HandlerDestructorUsesDelegate()
+{
+    struct Guard
+    {
+        Delegate<void()>* delegate;
+        int* destroyed;
+
+        Guard(Delegate<void()>* delegate, int* destroyed) : delegate(delegate), destroyed(destroyed) {}
+        Guard(Guard&& other) noexcept : delegate(std::exchange(other.delegate, nullptr)), destroyed(other.destroyed) {}
+
+        ~Guard()
+        {
+            if (!delegate)
+                return;
+            ++*destroyed;
+            delegate->Disconnect(delegate->Connect([] {}));
+        }
+
+        void operator()() const {}
+    };
+
+    int destroyed = 0;
+    Delegate<void()> delegate;
+    const auto connection = delegate.Emplace<Guard>(&delegate, &destroyed);
+    delegate.Fire();
+    CHECK(delegate.Disconnect(connection));
+    delegate.Fire();
+    CHECK(destroyed == 1);
+
+    // The same from inside a fire: the handler disconnects itself and is destroyed once the fire lets go of it.
+    Delegate<void()>::Connection own;
+    own = delegate.Emplace<Guard>(&delegate, &destroyed);
+    const auto remover = delegate.Connect([&] { delegate.Disconnect(own); });
+    delegate.Fire();
+    delegate.Fire();
+    CHECK(destroyed == 2);
+    CHECK(delegate.Disconnect(remover));
+}
+
+// Rvalue reference and move-only parameters: every handler but the last borrows, the last one takes over.
+static void MoveOnlyAndRvalueArguments()
+{
+    FunctionWrapper<int(std::unique_ptr<int>)> take([](std::unique_ptr<int> p) { return *p; });
+    CHECK(take(std::make_unique<int>(4)) == 4);
+
+    std::string log;
+    Delegate<void(std::string&&)> delegate;
+    delegate += [&](const std::string& s) { log += s; };
+    delegate += [&](std::string&& s) { log += std::string(std::move(s)); };
+    delegate += [&](std::string&& s) { log += std::string(std::move(s)); };
+    delegate.Fire(std::string("ab"));
+    CHECK(log == "ababab");
+
+    auto fixed = MakeStaticDelegate<int(std::unique_ptr<int>)>([](const std::unique_ptr<int>& p) { return *p; },
+                                                                [](std::unique_ptr<int> p) { return *p + 1; });
+    CHECK(fixed.Execute(std::make_unique<int>(1)) == std::vector<int>({1, 2}));
+}
+
+// Arguments only need to be copyable for Next(), firing a delegate with move-only ones must work without it. Every
+// handler has to borrow them then, a wrapper whose target takes them by value is turned away when connecting.
+static void MoveOnlyDelegate()
+{
+    Delegate<int(std::unique_ptr<int>)> delegate;
+    delegate += [](const std::unique_ptr<int>& p) { return *p; };
+    delegate += WithPriority(1, [](const std::unique_ptr<int>& p) { return *p * 2; });
+    CHECK(delegate.Execute(std::make_unique<int>(3)) == std::vector<int>({6, 3}));
+
+    std::vector<int> results;
+    delegate.ExecuteInto(results, std::make_unique<int>(5));
+    CHECK(results == std::vector<int>({10, 5}));
+
+    MoveOnlyFunctionWrapper<int(std::unique_ptr<int>)> taking([](std::unique_ptr<int> p) { return *p; });
+    CHECK(!taking.CanShare());
+    bool rejected = false;
+    try
+    {
+        delegate += std::move(taking);
+    }
+    catch (const std::logic_error&)
+    {
+        rejected = true;
+    }
+    CHECK(rejected);
+    CHECK(delegate.Execute(std::make_unique<int>(1)) == std::vector<int>({2, 1}));
+}
+
+// ExecuteAsync keeps its own copies of reference arguments, the caller's temporaries are gone when handlers run.
+static void ExecuteAsyncReferenceArguments()
+{
+    Delegate<std::size_t(const std::string&)> delegate;
+    delegate += [](const std::string& s) { return s.size(); };
+    delegate += [](const std::string& s) { return s.size() * 2; };
+    std::future<std::vector<std::size_t>> sizes = delegate.ExecuteAsync(std::string(100, 'x'));
+    CHECK(sizes.get() == std::vector<std::size_t>({100, 200}));
+
+    std::string text = "ab";
+    Delegate<void(std::string&)> appending;
+    appending += [](std::string& s) { s += 'c'; };
+    appending.ExecuteAsync(text).get();
+    CHECK(text == "ab");
+}
+
+// Starts right away and frees its frame when it returns, enough to drive co_await delegate.Next(). The lambdas
+// below are named since a coroutine lambda's captures live in the closure, not in the frame.
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::abort(); }
+    };
+};
+
+// Waiting coroutines resume after the handlers, in the order they started waiting, with their own copies of the
+// arguments, from Fire, ExecuteBatch and ExecuteAsync alike.
+static void NextResumes()
+{
+    std::string log;
+    Delegate<void(std::string&&)> delegate;
+    delegate += [&](std::string&& s) { log += "h:" + std::string(std::move(s)) + ' '; };
+
+    auto wait = [&](char name) -> DetachedTask
+    {
+        auto [s] = co_await delegate.Next();
+        log += name;
+        log += ':' + s + ' ';
+    };
+    wait('a');
+    wait('b');
+    CHECK(log.empty());
+    delegate.Fire(std::string("xy"));
+    CHECK(log == "h:xy a:xy b:xy ");
+
+    // Only the next fire resumes them.
+    log.clear();
+    delegate.Fire(std::string("z"));
+    CHECK(log == "h:z ");
+
+    Delegate<int(int)> batch;
+    batch += [](int x) { return x; };
+    std::vector<int> seen;
+    auto watch = [&]() -> DetachedTask
+    {
+        for (int i = 0; i < 2; ++i)
+            seen.push_back(std::get<0>(co_await batch.Next()));
+    };
+    watch();
+    const std::array<std::tuple<int>, 3> events = {std::tuple<int>(4), std::tuple<int>(5), std::tuple<int>(6)};
+    std::array<int, 3> results{};
+    batch.ExecuteBatch<Combiners::Sum>(std::span<const std::tuple<int>>(events), std::span<int>(results));
+    CHECK(seen == std::vector<int>({4}));
+    batch.Fire(7);
+    CHECK(seen == std::vector<int>({4, 7}));
+
+    // ExecuteAsync resumes the coroutine on the pool thread once the handlers there have run.
+    std::atomic<int> resumed = 0;
+    std::atomic<bool> handled = false;
+    Delegate<void(const std::string&)> async;
+    async += [&](const std::string&) { handled.store(true); };
+    auto await_async = [&]() -> DetachedTask
+    {
+        auto [s] = co_await async.Next();
+        resumed.store(handled.load() && s == "async" ? 1 : 2);
+    };
+    await_async();
+    async.ExecuteAsync(std::string("async")).get();
+    while (resumed.load() == 0)
+        std::this_thread::yield();
+    CHECK(resumed.load() == 1);
+}
+
+// An undersized span must not change who receives the event.
+static void ExecuteIntoShortSpan()
+{
+    int calls = 0;
+    Delegate<int(int)> delegate;
+    for (int i = 0; i < 4; ++i)
+        delegate += [&calls, i](int x) { ++calls; return x + i; };
+
+    std::array<int, 2> results{};
+    CHECK(delegate.ExecuteInto(std::span<int>(results), 10) == 4);
+    CHECK(calls == 4 && results[0] == 10 && results[1] == 11);
+
+    CHECK(delegate.ExecuteInto(std::span<int>(), 10) == 4);
+    CHECK(calls == 8);
+}
+
+// Copying a move-only target is a compile-time error, copyable wrappers hand their targets to move-only ones.
+static void CopyableAndMoveOnlyWrappers()
+{
+    using Owning = decltype([p = std::unique_ptr<int>()](int) { return 0; });
+    static_assert(!std::is_constructible_v<FunctionWrapper<int(int)>, Owning>);
+    static_assert(std::is_constructible_v<MoveOnlyFunctionWrapper<int(int)>, Owning>);
+    static_assert(!std::is_copy_constructible_v<MoveOnlyFunctionWrapper<int(int)>>);
+    // No move-only wrapper reference can alias a copyable wrapper and have a move-only target assigned through it.
+    static_assert(!std::is_convertible_v<FunctionWrapper<int(int)>&, MoveOnlyFunctionWrapper<int(int)>&>);
+
+    MoveOnlyFunctionWrapper<int(int)> owning([p = std::make_unique<int>(2)](int x) { return x * *p; });
+    MoveOnlyFunctionWrapper<int(int)> moved = std::move(owning);
+    CHECK(!owning && moved(3) == 6);
+
+    const FunctionWrapper<int(int)> copyable([](int x) { return x + 1; });
+    MoveOnlyFunctionWrapper<int(int)> copied = copyable;
+    CHECK(copied(1) == 2 && copyable(1) == 2);
+
+    Delegate<int(int)> delegate;
+    delegate += copyable;
+    delegate += [p = std::make_unique<int>(3)](int x) { return x * *p; };
+    CHECK(delegate.Execute(2) == std::vector<int>({3, 6}));
+}
+
+// BindWeak<&T::m> takes the object as a shared_ptr as well as a weak_ptr, neither keeps it alive.
+static void BindWeakSharedPtr()
+{
+    struct Listener
+    {
+        int calls = 0;
+        void OnEvent(int x) { calls += x; }
+    };
+
+    auto listener = std::make_shared<Listener>();
+    Delegate<void(int)> delegate;
+    const auto connection = delegate.BindWeak<&Listener::OnEvent>(listener);
+    delegate.BindWeak<&Listener::OnEvent>(std::weak_ptr<Listener>(listener), 1);
+    CHECK(listener.use_count() == 1);
+
+    delegate.Fire(2);
+    CHECK(listener->calls == 4);
+
+    // The fire that finds the listener gone marks it, the next one publishes without it.
+    listener.reset();
+    delegate.Fire(2);
+    delegate.Fire(2);
+    CHECK(!delegate.Connected(connection));
+    CHECK(!delegate.BindWeak<&Listener::OnEvent>(std::shared_ptr<Listener>()));
+}
+
+// Producers post concurrently while the consumer pumps: every event arrives once, in posting order per producer.
+static void QueuedDelegateProducers()
+{
+    constexpr int producers = 4;
+    constexpr int per_producer = 20000;
+    std::array<int, producers> next{};
+    bool ordered = true;
+    Delegate<void(int, int)> target;
+    target += [&](int producer, int sequence)
+    {
+        ordered = ordered && next[producer] == sequence;
+        next[producer] = sequence + 1;
+    };
+
+    QueuedDelegate<void(int, int)> queue(target, 64);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&queue, p]
+        {
+            for (int i = 0; i < per_producer; ++i)
+            {
+                while (!queue.Post(p, i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::size_t pumped = 0;
+    while (pumped < std::size_t(producers) * per_producer)
+        pumped += queue.Pump();
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(ordered);
+    CHECK(queue.Pump() == 0);
+    for (int p = 0; p < producers; ++p)
+        CHECK(next[p] == per_producer);
+}
+
+// A full ring turns events away until the consumer makes room, and events still queued are destroyed with it.
+static void QueuedDelegateFullAndDestroyed()
+{
+    int fired = 0;
+    Delegate<void(std::shared_ptr<int>)> target;
+    target += [&](const std::shared_ptr<int>& p) { fired += *p; };
+
+    auto payload = std::make_shared<int>(1);
+    {
+        QueuedDelegate<void(std::shared_ptr<int>)> queue(target, 4);
+        CHECK(queue.Capacity() == 4);
+        for (int i = 0; i < 4; ++i)
+            CHECK(queue.Post(payload));
+        CHECK(!queue.Post(payload));
+        CHECK(payload.use_count() == 5);
+
+        CHECK(queue.Pump(1) == 1);
+        CHECK(fired == 1);
+        CHECK(queue.Post(payload));
+        CHECK(!queue.Post(payload));
+        CHECK(payload.use_count() == 5);
+    }
+    CHECK(payload.use_count() == 1);
+    CHECK(fired == 1);
+}
+
+// ExecuteParallel returns the results in subscription order whatever order the chunks finish in.
+static void ExecuteParallelOrder()
+{
+    Delegate<int(int)> delegate;
+    delegate.SetParallelGrainSize(3);
+    std::vector<int> expected;
+    for (int i = 0; i < 50; ++i)
+    {
+        delegate += [i](int x)
+        {
+            if (i % 7 == 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            return x + i;
+        };
+        expected.push_back(100 + i);
+    }
+    for (int round = 0; round < 20; ++round)
+        CHECK(delegate.ExecuteParallel(100) == expected);
+
+    std::atomic<int> calls = 0;
+    Delegate<void()> fire;
+    fire.SetParallelGrainSize(2);
+    for (int i = 0; i < 9; ++i)
+        fire += [&] { ++calls; };
+    fire.ExecuteParallel();
+    CHECK(calls.load() == 9);
+}
+
+// Handlers running on pool workers may fan out again: the waiting workers help instead of blocking the pool.
+static void NestedExecuteParallel()
+{
+    Delegate<int(int)> inner;
+    inner.SetParallelGrainSize(1);
+    for (int i = 0; i < 8; ++i)
+        inner += [](int x) { return x; };
+
+    Delegate<int(int)> outer;
+    outer.SetParallelGrainSize(1);
+    for (int i = 0; i < 2 * static_cast<int>(WorkStealingThreadPool::Default().Size()) + 2; ++i)
+    {
+        outer += [&inner](int x)
+        {
+            const std::vector<int> results = inner.ExecuteParallel(x);
+            int sum = 0;
+            for (int r : results)
+                sum += r;
+            return sum;
+        };
+    }
+
+    const std::vector<int> sums = outer.ExecuteParallel(1);
+    CHECK(sums.size() == outer.Execute(1).size());
+    bool all = true;
+    for (int sum : sums)
+        all = all && sum == 8;
+    CHECK(all);
+}
+
+// A pool runs every task submitted to it, including those submitted by its own tasks, before it is destroyed.
+static void ThreadPoolDrains()
+{
+    std::atomic<int> ran = 0;
+    {
+        WorkStealingThreadPool pool(3);
+        for (int i = 0; i < 500; ++i)
+        {
+            pool.Submit([&pool, &ran]
+            {
+                ++ran;
+                pool.Submit([&ran] { ++ran; });
+            });
+        }
+        while (ran.load() < 1000)
+        {
+            if (!pool.TryRunOne())
+                std::this_thread::yield();
+        }
+        for (int i = 0; i < 100; ++i)
+            pool.Submit([&ran] { ++ran; });
+    }
+    CHECK(ran.load() == 1100);
+}
+
+// Batches longer than one block of combiners, and results spans shorter than the batch.
+static void ExecuteBatchBlocks()
+{
+    int calls = 0;
+    Delegate<int(int)> delegate;
+    delegate += [&](int x) { ++calls; return x; };
+    delegate += [&](int x) { ++calls; return 2 * x; };
+
+    std::vector<std::tuple<int>> events;
+    for (int i = 0; i < 1000; ++i)
+        events.emplace_back(i);
+
+    std::vector<int> sums(events.size());
+    delegate.ExecuteBatch<Combiners::Sum>(events, std::span<int>(sums));
+    bool all = calls == 2000;
+    for (int i = 0; i < 1000; ++i)
+        all = all && sums[i] == 3 * i;
+    CHECK(all);
+
+    std::array<int, 3> few{};
+    delegate.ExecuteBatch<Combiners::Sum>(events, std::span<int>(few));
+    CHECK(calls == 4000 && few[0] == 0 && few[1] == 3 && few[2] == 6);
+}
+
+int main()
+{
+    PriorityInsertBehindTombstone();
+    ConcurrentPriorityChurn();
+    NoCallAfterDisconnect();
+    Reentrancy();
+    HandlerDestructorUsesDelegate();
+    MoveOnlyAndRvalueArguments();
+    MoveOnlyDelegate();
+    ExecuteIntoShortSpan();
+    ExecuteAsyncReferenceArguments();
+    NextResumes();
+    CopyableAndMoveOnlyWrappers();
+    BindWeakSharedPtr();
+    ExecuteBatchBlocks();
+    ExecuteParallelOrder();
+    NestedExecuteParallel();
+    ThreadPoolDrains();
+    QueuedDelegateProducers();
+    QueuedDelegateFullAndDestroyed();
+
+    if (failures)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures.load());
+        return EXIT_FAILURE;
+    }
+    std::puts("all tests passed");
+    return EXIT_SUCCESS;
+}